@@ -0,0 +1,442 @@
+/*
+
+Spa Employee System - benchmark
+
+Generates a synthetic roster and appointment book, then times the core operations on it
+and prints one JSON object per line: the configuration first, then one line per operation
+with its count, throughput and latency percentiles in nanoseconds. Build and run with
+	cc -O2 -pthread -o bench bench.c spa_core.c -lm
+	./bench -e 10000 -a 100 -q 100000 -z 1.0 > results.jsonl
+
+	-e N	employees in the generated roster (default 10000)
+	-a N	appointments per employee in the generated book (default 100)
+	-q N	queries, bookings and cancellations per timed operation (default 100000)
+	-r N	repetitions of the load and save operations (default 3)
+	-t N	threads for loadTextFiles (default 0, one per core)
+	-z S	skew of the employee picked by each query: 0 is uniform, S > 0 is Zipf with exponent S
+	-s N	random seed (default 1)
+	-d DIR	scratch directory for the generated files (default spa_bench.tmp)
+
+The journal stays closed, so hires, bookings and cancellations are timed without their
+journal writes. Each latency includes one clock read, roughly 20-30 ns. The date conversions
+are each timed twice on the same input: through the core's integer routines, and as a "_libc"
+line through the mktime/localtime/strftime calls they replaced. Set TZ to the zone to measure;
+left unset, glibc rereads the zone name on every mktime.
+
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#define mkdir(dir, mode) _mkdir(dir)
+#define chdir _chdir
+#define rmdir _rmdir
+#else
+#include <unistd.h>
+#endif
+#include "spa_core.h"
+
+//one timed operation: a latency per call, in nanoseconds
+typedef struct sample{
+	const char * op;
+	uint64_t * ns;
+	long count;
+	long capacity;
+	long items; //records handled, for bulk operations; 0 means one per call
+	long conflicts;
+	long misses;
+} Sample;
+
+//bench functions
+uint64_t nowNs ();
+uint64_t nextRandom ();
+int pickEmployee ();
+void writeRoster (int employees, int perEmployee);
+void beginSample (Sample * sample, const char * op, long capacity);
+void record (Sample * sample, uint64_t start);
+void reportSample (Sample * sample);
+int compareNs (const void * a, const void * b);
+void libcLocalTime (time_t t, struct tm * out);
+
+uint64_t randomState = 1;
+double * zipfTable = NULL; //cumulative weights of employee numbers 1..employees, or NULL for uniform
+int rosterSize = 0;
+
+int main (int argc, char ** argv){
+	int employees = 10000, perEmployee = 100, queries = 100000, reps = 3;
+	double skew = 0;
+	const char * dir = "spa_bench.tmp";
+	int i, r;
+	for (i = 1; i + 1 < argc; i += 2){
+		if (strcmp(argv[i], "-e") == 0){
+			employees = atoi(argv[i+1]);
+		} else if (strcmp(argv[i], "-a") == 0){
+			perEmployee = atoi(argv[i+1]);
+		} else if (strcmp(argv[i], "-q") == 0){
+			queries = atoi(argv[i+1]);
+		} else if (strcmp(argv[i], "-r") == 0){
+			reps = atoi(argv[i+1]);
+		} else if (strcmp(argv[i], "-t") == 0){
+			loadThreads = atoi(argv[i+1]);
+		} else if (strcmp(argv[i], "-z") == 0){
+			skew = atof(argv[i+1]);
+		} else if (strcmp(argv[i], "-s") == 0){
+			randomState = strtoull(argv[i+1], NULL, 10);
+		} else if (strcmp(argv[i], "-d") == 0){
+			dir = argv[i+1];
+		} else{
+			fprintf(stderr, "usage: %s [-e employees] [-a per-employee] [-q queries] [-r reps] [-t threads] [-z skew] [-s seed] [-d dir]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (employees < 1 || perEmployee < 0 || queries < 1 || reps < 1){
+		fprintf(stderr, "NOTE: counts must be positive.\n");
+		return 1;
+	}
+	if (randomState == 0){
+		randomState = 1;
+	}
+	mkdir(dir, 0755);
+	if (chdir(dir) != 0){
+		fprintf(stderr, "NOTE: could not use %s as the scratch directory.\n", dir);
+		return 1;
+	}
+
+	rosterSize = employees;
+	if (skew > 0){
+		zipfTable = (double *) malloc(employees * sizeof(double));
+		double total = 0;
+		for (i = 0; i < employees; i++){
+			total += 1.0 / pow(i + 1, skew);
+			zipfTable[i] = total;
+		}
+		for (i = 0; i < employees; i++){
+			zipfTable[i] /= total;
+		}
+	}
+	printf("{\"bench\":\"spa\",\"employees\":%d,\"per_employee\":%d,\"queries\":%d,\"reps\":%d,\"threads\":%d,\"skew\":%g,\"seed\":%llu}\n", employees, perEmployee, queries, reps, loadThreads, skew, (unsigned long long) randomState);
+	writeRoster(employees, perEmployee);
+
+	Employee * head = NULL;
+	Sample sample;
+	uint64_t start;
+	long apps = (long) employees * perEmployee;
+
+	//bulk loads and saves, each repeated on a fresh store
+	Sample loadEmp, loadApp, loadText, saveEmp, saveApp;
+	beginSample(&loadEmp, "loadEmployees", reps);
+	beginSample(&loadText, "loadTextFiles", reps);
+	beginSample(&loadApp, "loadAppointments", reps);
+	beginSample(&saveEmp, "saveEmployees", reps);
+	beginSample(&saveApp, "saveAppointments", reps);
+	loadEmp.items = (long) employees * reps;
+	loadApp.items = apps * reps;
+	loadText.items = ((long) employees + apps) * reps;
+	saveEmp.items = (long) employees * reps;
+	saveApp.items = apps * reps;
+	for (r = 0; r < reps; r++){
+		fireAllEmployees(&head);
+		start = nowNs();
+		head = loadEmployees(head);
+		record(&loadEmp, start);
+		start = nowNs();
+		loadApp.misses += loadAppointments(head);
+		record(&loadApp, start);
+		start = nowNs();
+		saveEmployees(head);
+		record(&saveEmp, start);
+		start = nowNs();
+		saveAppointments(head);
+		record(&saveApp, start);
+		fireAllEmployees(&head);
+		start = nowNs();
+		loadText.misses += loadTextFiles(&head);
+		record(&loadText, start);
+	}
+	reportSample(&loadEmp);
+	reportSample(&loadApp);
+	reportSample(&loadText);
+	reportSample(&saveEmp);
+	reportSample(&saveApp);
+
+	beginSample(&sample, "findEmp", queries);
+	for (i = 0; i < queries; i++){
+		int empNum = pickEmployee();
+		start = nowNs();
+		Employee * emp = findEmp(head, empNum);
+		record(&sample, start);
+		sample.misses += (emp == NULL);
+	}
+	reportSample(&sample);
+
+	beginSample(&sample, "findBookedEmp", queries);
+	for (i = 0; i < queries && apps > 0; i++){
+		int appId = 1 + (int) (nextRandom() % apps);
+		start = nowNs();
+		Employee * emp = findBookedEmp(head, appId);
+		record(&sample, start);
+		sample.misses += (emp == NULL);
+	}
+	reportSample(&sample);
+
+	beginSample(&sample, "hireEmployee", queries);
+	for (i = 0; i < queries; i++){
+		static const char * syllables[12] = {"ka", "lo", "pe", "zu", "mi", "ra", "to", "ne", "si", "va", "do", "ri"};
+		char last[NAME_SIZE], first[NAME_SIZE];
+		Employee details;
+		sprintf(last, "%s%s%s%s", syllables[nextRandom() % 12], syllables[nextRandom() % 12], syllables[nextRandom() % 12], syllables[nextRandom() % 12]);
+		sprintf(first, "%s%s%s", syllables[nextRandom() % 12], syllables[nextRandom() % 12], syllables[nextRandom() % 12]);
+		last[0] -= 'a' - 'A';
+		first[0] -= 'a' - 'A';
+		setEmpName(&details, last, first);
+		details.age = 18 + nextRandom() % 48;
+		details.position = nextRandom() % POSITION_COUNT;
+		details.hired = daysFromCivil(2000 + nextRandom() % 26, 1 + nextRandom() % 12, 1 + nextRandom() % 28);
+		start = nowNs();
+		hireEmployee(&head, &details, NULL);
+		record(&sample, start);
+	}
+	reportSample(&sample);
+
+	//requests land on working hours in the weeks the generated book covers, so some conflict
+	int firstDay = daysFromCivil(2026, 1, 1);
+	int weeks = 1 + perEmployee / 40;
+	int * booked = (int *) malloc(queries * sizeof(int));
+	int bookedCount = 0;
+	beginSample(&sample, "bookAppointment", queries);
+	for (i = 0; i < queries; i++){
+		Employee * emp = findEmp(head, pickEmployee());
+		time_t when = localToTime(firstDay + nextRandom() % (weeks * 7), 8 * 60 + (nextRandom() % 40) * 15);
+		int length = 30 * 60 * (1 + nextRandom() % 3);
+		int id;
+		start = nowNs();
+		int status = bookAppointment(emp, when, length, &id);
+		record(&sample, start);
+		if (status == SPA_OK){
+			booked[bookedCount++] = id;
+		} else if (status == SPA_CONFLICT){
+			sample.conflicts++;
+		} else{
+			sample.misses++;
+		}
+	}
+	reportSample(&sample);
+
+	beginSample(&sample, "cancelAppointment", queries);
+	for (i = 0; i < queries; i++){
+		//half the new bookings, half the loaded ones
+		int appId = (i % 2 == 0 && bookedCount > 0) ? booked[nextRandom() % bookedCount] : 1 + (int) (nextRandom() % (apps > 0 ? apps : 1));
+		start = nowNs();
+		int status = cancelAppointment(appId);
+		record(&sample, start);
+		sample.misses += (status != SPA_OK);
+	}
+	reportSample(&sample);
+	free(booked);
+
+	//the libc path validates a date by a mktime round trip and checks that strftime gives it back
+	Sample libc;
+	beginSample(&sample, "parseDate", queries);
+	beginSample(&libc, "parseDate_libc", queries);
+	for (i = 0; i < queries; i++){
+		char text[12], back[16];
+		int days, month, day, year;
+		struct tm date;
+		sprintf(text, "%02d/%02d/%02d", (int) (1 + nextRandom() % 12), (int) (1 + nextRandom() % 31), (int) (nextRandom() % 100));
+		start = nowNs();
+		sample.misses += (parseDate(text, &days) == EXITED);
+		record(&sample, start);
+		start = nowNs();
+		memset(&date, 0, sizeof(date));
+		sscanf(text, "%d/%d/%d", &month, &day, &year);
+		date.tm_mon = month - 1;
+		date.tm_mday = day;
+		date.tm_year = fullYear(year) - 1900;
+		date.tm_isdst = -1;
+		time_t t = mktime(&date);
+		libcLocalTime(t, &date);
+		strftime(back, sizeof(back), "%x", &date);
+		libc.misses += (t == -1 || strcmp(back, text) != 0);
+		record(&libc, start);
+	}
+	reportSample(&sample);
+	reportSample(&libc);
+
+	beginSample(&sample, "formatSchedule", queries);
+	beginSample(&libc, "formatSchedule_libc", queries);
+	for (i = 0; i < queries; i++){
+		char text[32];
+		struct tm schedule;
+		time_t when = localToTime(firstDay + nextRandom() % 3650, nextRandom() % 1440);
+		start = nowNs();
+		formatSchedule(text, when);
+		record(&sample, start);
+		start = nowNs();
+		libcLocalTime(when, &schedule);
+		strftime(text, sizeof(text), "%x at %I:%M%p", &schedule);
+		record(&libc, start);
+	}
+	reportSample(&sample);
+	reportSample(&libc);
+
+	beginSample(&sample, "localToTime", queries);
+	beginSample(&libc, "localToTime_libc", queries);
+	for (i = 0; i < queries; i++){
+		int days = firstDay + nextRandom() % 3650, minutes = nextRandom() % 1440;
+		int year, month, day;
+		struct tm schedule;
+		start = nowNs();
+		localToTime(days, minutes);
+		record(&sample, start);
+		start = nowNs();
+		civilFromDays(days, &year, &month, &day);
+		memset(&schedule, 0, sizeof(schedule));
+		schedule.tm_year = year - 1900;
+		schedule.tm_mon = month - 1;
+		schedule.tm_mday = day;
+		schedule.tm_hour = minutes / 60;
+		schedule.tm_min = minutes % 60;
+		schedule.tm_isdst = -1;
+		mktime(&schedule);
+		record(&libc, start);
+	}
+	reportSample(&sample);
+	reportSample(&libc);
+
+	remove("employees.txt");
+	remove("appointments.txt");
+	chdir("..");
+	rmdir(dir);
+	return 0;
+}
+
+uint64_t nowNs (){
+	struct timespec ts;
+#ifdef _WIN32
+	timespec_get(&ts, TIME_UTC);
+#else
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+//xorshift64*, so a seed gives the same workload on every platform
+uint64_t nextRandom (){
+	randomState ^= randomState >> 12;
+	randomState ^= randomState << 25;
+	randomState ^= randomState >> 27;
+	return randomState * 2685821657736338717ull;
+}
+
+int pickEmployee (){
+	if (zipfTable == NULL){
+		return 1 + (int) (nextRandom() % rosterSize);
+	}
+	double u = (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+	int lo = 0, hi = rosterSize - 1;
+	while (lo < hi){
+		int mid = lo + (hi - lo) / 2;
+		if (zipfTable[mid] < u){
+			lo = mid + 1;
+		} else{
+			hi = mid;
+		}
+	}
+	return lo + 1;
+}
+
+//employees.txt and appointments.txt in the formats the program saves; each employee's
+//appointments follow one another in working hours, so none of them conflict
+void writeRoster (int employees, int perEmployee){
+	static const char * syllables[12] = {"ka", "lo", "pe", "zu", "mi", "ra", "to", "ne", "si", "va", "do", "ri"};
+	FILE * fp = fopen("employees.txt", "w");
+	FILE * fl = fopen("appointments.txt", "w");
+	int firstDay = daysFromCivil(2026, 1, 1);
+	int e, k, appId = 0;
+	if (fp == NULL || fl == NULL){
+		fprintf(stderr, "NOTE: could not write the generated files.\n");
+		exit(1);
+	}
+	for (e = 1; e <= employees; e++){
+		char last[NAME_SIZE], first[NAME_SIZE], date[9];
+		sprintf(last, "%s%s%s%s", syllables[nextRandom() % 12], syllables[nextRandom() % 12], syllables[nextRandom() % 12], syllables[nextRandom() % 12]);
+		sprintf(first, "%s%s%s", syllables[nextRandom() % 12], syllables[nextRandom() % 12], syllables[nextRandom() % 12]);
+		last[0] -= 'a' - 'A';
+		first[0] -= 'a' - 'A';
+		formatDate(date, daysFromCivil(2000 + nextRandom() % 26, 1 + nextRandom() % 12, 1 + nextRandom() % 28));
+		fprintf(fp, "-----------EMPLOYEE INFO-----------\n%s\n%s\n%d\n%d\n%s\n%s\n", last, first, e, (int) (18 + nextRandom() % 48), positionNames[nextRandom() % POSITION_COUNT], date);
+
+		fprintf(fl, "EMPLOYEE|%d\n", e);
+		int minute = 0; //minutes into the working days, ten hours a day from 08:00
+		for (k = 0; k < perEmployee; k++){
+			int length = 30 * (1 + nextRandom() % 2);
+			minute += 60 * (1 + nextRandom() % 3);
+			formatDate(date, firstDay + minute / 600);
+			fprintf(fl, "%s|%02d:%02d|%d|%d\n", date, 8 + minute % 600 / 60, minute % 60, ++appId, length);
+		}
+		fprintf(fl, "---END---\n");
+	}
+	fclose(fp);
+	fclose(fl);
+}
+
+void beginSample (Sample * sample, const char * op, long capacity){
+	memset(sample, 0, sizeof(Sample));
+	sample->op = op;
+	sample->ns = (uint64_t *) malloc(capacity * sizeof(uint64_t));
+	sample->capacity = capacity;
+	if (sample->ns == NULL){
+		fprintf(stderr, "NOTE: out of memory.\n");
+		exit(1);
+	}
+}
+
+void record (Sample * sample, uint64_t start){
+	uint64_t end = nowNs();
+	if (sample->count < sample->capacity){
+		sample->ns[sample->count++] = end - start;
+	}
+}
+
+void libcLocalTime (time_t t, struct tm * out){
+#ifdef _WIN32
+	localtime_s(out, &t);
+#else
+	localtime_r(&t, out);
+#endif
+}
+
+int compareNs (const void * a, const void * b){
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+	return (x > y) - (x < y);
+}
+
+void reportSample (Sample * sample){
+	uint64_t total = 0;
+	long i;
+	if (sample->count == 0){
+		free(sample->ns);
+		return;
+	}
+	for (i = 0; i < sample->count; i++){
+		total += sample->ns[i];
+	}
+	qsort(sample->ns, sample->count, sizeof(uint64_t), compareNs);
+	long items = (sample->items > 0) ? sample->items : sample->count;
+	printf("{\"op\":\"%s\",\"count\":%ld,\"items\":%ld,\"ops_per_sec\":%.0f,\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu,\"conflicts\":%ld,\"misses\":%ld}\n",
+		sample->op, sample->count, items, total > 0 ? items * 1e9 / total : 0.0,
+		(unsigned long long) sample->ns[(sample->count - 1) * 50 / 100],
+		(unsigned long long) sample->ns[(sample->count - 1) * 90 / 100],
+		(unsigned long long) sample->ns[(sample->count - 1) * 99 / 100],
+		(unsigned long long) sample->ns[sample->count - 1],
+		sample->conflicts, sample->misses);
+	fflush(stdout);
+	free(sample->ns);
+}
@@ -2,7 +2,14 @@
 
 Spa Employee System
 
-This program organizes employee and appointment information through a linked list data structure. Users can add, edit, view, and delete one or all employees and appointments of a spa via a menu interface. Data regarding employees are stored in alphabetical order while appointments are stored in ascending order. Furthermore, users are notified if they attempt to create appointments that conflict with preexisting ones, i.e. within 30 minutes of old appointments. Users can save employee and appointment information via text files. 
+This program organizes employee and appointment information through a linked list data structure. Users can add, edit, view, and delete one or all employees and appointments of a spa via a menu interface. Data regarding employees are stored in alphabetical order while appointments are stored in ascending order, each employee's in a balanced interval tree threaded with an in-order list. Furthermore, users are notified if they attempt to create appointments that conflict with preexisting ones, i.e. whose time slots overlap. Users can save employee and appointment information via text files. 
+
+This file is the menu front end; the data structures and files are handled by spa_core.c. Build with
+	cc -O2 -pthread -o spa spa.c spa_core.c spa_batch.c
+or, to count the work done and time each menu operation into spa.stats, with
+	cc -O2 -pthread -DSPA_STATS -o spa spa.c spa_core.c spa_batch.c
+Run as "spa -b commands.txt" (or "-b -" for stdin) to apply a command file without prompts and
+print one summary; the command format is described in spa_batch.h.
 
 @Author Jose Enrique R. Lopez
 @Date Created 10-12-19
@@ -16,35 +23,9 @@ This program organizes employee and appointment information through a linked lis
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
-#define ACTIVE 1
-#define EXITED 0
-
-typedef struct app_node{
-	int id;
-	struct tm schedule;
-	struct app_node * next;
-} Appointment;
-
-typedef struct name{
-	char last[20];
-	char first[20];
-} Name;
-
-typedef struct date{
-	int month;
-	int day;
-	int year;
-} Date;
-
-typedef struct emp_node{
-	int empNum;
-	Name name;
-	int age;
-	char position [30];
-	struct tm dateHired;
-    Appointment * app;                                                                                                                                                                                             
-	struct emp_node * next;
-} Employee;
+#include "spa_core.h"
+#include "spa_batch.h"
+#define FREE_SLOTS_SHOWN 5 //earliest free slots listed for a walk-in
 
 //utilities functions
 void printBanner();
@@ -53,49 +34,66 @@ int showEmpMenu();
 int showAppMenu();
 int enterEmpNum();
 int enterAppId();
-struct tm inputDate (struct tm timestamp);
-struct tm inputTime (struct tm timestamp);
+int confirmChoice();
+int inputDate ();
+int inputTime ();
+int inputLength ();
 void showEmpDetails (Employee * emp);
+void showPositions ();
 void showApps (Employee * emp);
-
-//save/load functions
-void saveEmployees (Employee * head, FILE * fp);
-void saveAppointments (Employee * head, FILE * fp);
+void saveFiles (Employee * head);
+int batchMode (Employee ** head, const char * name);
 
 //primary functions
-Employee * loadEmployees (Employee * head, FILE * fp);
-void loadAppointments (Appointment ** ptr, FILE ** fl);
-Employee * addEmployee(Employee * head, Employee * emp);
-Employee * createEmployee();
-void editEmployee(Employee * head);
+Employee * createEmployee(Employee * head);
+Employee * editEmployee(Employee * head);
 Employee * delEmployee(Employee * head);
 void viewAllEmps(Employee * head);
 void viewEmpByNum(Employee * head);
-Employee * findEmp (Employee * head, int empNum);
-Employee * findBookedEmp (Employee * head, int appId);
 void viewByPosition(Employee * head);
+void viewBySurname(Employee * head);
 void viewEmployee(Employee * head);
-Appointment * addAppointment(Appointment * head, Appointment * newApp);
-Employee * editAppointment(Employee * head, Appointment * appHead, int id);
+void addAppointment(Employee * emp);
+Employee * editAppointment(Employee * head, int id);
+int moveAppointment (Appointment * app, Employee * emp, time_t start, int id, int * conflictId);
 Employee * delAppointment(Employee * head, int id);
+void bookFreeSlot();
+void viewSchedule();
+void showDay (int day);
+void viewTimeline();
 void showAppDetails (Appointment * app);
-Appointment * delAppByNum(Appointment * head, int * success);
 
-int maxGlobalID = 0;
-
-int main (void){
-	FILE * fp, * fl;
+int main (int argc, char ** argv){
 	int status = ACTIVE;
 	Employee * head = NULL;
-	head = loadEmployees(head, fp);
+	LoadReport report;
+	STAT_BEGIN(loadStart);
+	loadStore(&head, &report);
+	STAT_END(OP_LOAD, loadStart);
+	if (report.snapshotRejected){
+		printf("NOTE: spa.snap is damaged or from another version; loading the text files instead.\n");
+	}
+	if (report.skipped > 0){
+		printf("NOTE: %d appointments in appointments.txt could not be loaded.\n", report.skipped);
+	}
+	if (report.recovered > 0){
+		printf("NOTE: recovered %d unsaved changes from spa.journal.\n", report.recovered);
+	}
+	if (argc == 3 && strcmp(argv[1], "-b") == 0){
+		return batchMode(&head, argv[2]);
+	} else if (argc != 1){
+		printf("usage: %s [-b commands.txt]\n", argv[0]);
+		closeStore();
+		return 1;
+	}
 
 	
 	while (status == ACTIVE){
 		Employee * emp = NULL;
 		switch(showMainMenu()){
 			case 1: switch(showEmpMenu()){
-						case 1: head = addEmployee(head, emp);	break;
-						case 2: editEmployee(head);			break;
+						case 1: head = createEmployee(head);	break;
+						case 2: head = editEmployee(head);	break;
 						case 3: head = delEmployee(head);	break;
 						case 4: viewEmployee(head);			break;
 						case 0: break;
@@ -104,17 +102,14 @@ int main (void){
 					
 			case 2: switch(showAppMenu()){	
 					int choice;
-					Appointment * newApp;
 					int id;
 					case 1:
-						printf("Book a 30-minute appointment with one of our lovely staff!");
-						newApp = NULL;
+						printf("Book an appointment with one of our lovely staff!");
 						viewAllEmps(head);
 						choice = enterEmpNum(head);
 						emp = findEmp(head, choice);
 						if (emp!=NULL){
-							Appointment * appHead = emp->app;
-							emp->app = addAppointment(appHead, newApp);  
+							addAppointment(emp);  
 						} else{
 							printf("Employee does not exist!");
 						}
@@ -125,8 +120,7 @@ int main (void){
 					if (emp!= NULL){
 						printf("\n~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~");
 						printf("\nAppointment Details: \n");
-						Appointment * appHead = emp->app;  
-						head = editAppointment (head, appHead, id);
+						head = editAppointment (head, id);
  					} else{
 						printf("Appointment does not exist!");
 					}
@@ -136,163 +130,92 @@ int main (void){
 					id = enterAppId();
 					head = delAppointment(head, id);
 					break;
+					case 4:
+						bookFreeSlot();
+					break;
+					case 5:
+						viewSchedule();
+					break;
+					case 6:
+						viewTimeline();
+					break;
 					case 0:
 						break;
 					default:
 						printf("Please pick a valid option.");	
 				}
 				break;
-			case 0: saveEmployees(head, fp); saveAppointments(head,fp);	status = EXITED;	break;
+#ifdef SPA_STATS
+			case 3:
+				if (writeStats(STATS_FILE) == SPA_OK){
+					printf("\nStatistics written to %s.\n", STATS_FILE);
+				} else{
+					printf("NOTE: could not write %s.\n", STATS_FILE);
+				}
+				break;
+#endif
+			case 0: saveFiles(head);	status = EXITED;	break;
 			default: printf("\nPlease pick a valid option.\n");		break;
 		}
+		if (journalCount >= JOURNAL_COMPACT){
+			saveFiles(head);
+		}
 	}
+	closeStore();
+#ifdef SPA_STATS
+	if (writeStats(STATS_FILE) != SPA_OK){
+		printf("NOTE: could not write %s.\n", STATS_FILE);
+	}
+#endif
+	reportPools(head, stdout);
 	return 0;
 }
 
-void saveEmployees (Employee * head, FILE * fp){
-	Employee * temp = NULL;
-	temp = head;
-	fp = fopen("employees.txt", "w");
-	while (temp!=NULL){
-		fprintf(fp, "-----------EMPLOYEE INFO-----------\n");
-		fprintf(fp, "%s", temp->name.last);
-		fprintf(fp, "%s", temp->name.first);
-		fprintf(fp, "%d\n", temp->empNum);
-		fprintf(fp, "%d\n", temp->age);
-		fprintf(fp, "%s\n", temp->position);
-		char date[12];
-		strftime(date, sizeof(date), "%x", &temp->dateHired);
-		fprintf(fp, "%s\n", date);		
-		temp = temp->next;
+void saveFiles (Employee * head){
+	STAT_BEGIN(saveStart);
+	int status = saveStore(head);
+	STAT_END(OP_SAVE, saveStart);
+	if (status != SPA_OK){
+		printf("NOTE: could not write the data files; changes are kept in spa.journal.\n");
 	}
-	fclose(fp);
 }
 
-void saveAppointments (Employee * head, FILE * fp){
-	Employee * temp = NULL;
-	temp = head;
-	fp = fopen("appointments.txt", "w");
-	while (temp!=NULL){
-		Appointment * appTemp = NULL;
-		appTemp = temp->app;
-		while(appTemp!=NULL){
-			char appDate[20];
-			strftime(appDate, sizeof(appDate), "%x|%H:%M", &appTemp->schedule);
-			fprintf (fp, "%s|%d\n", appDate, appTemp->id);
-			appTemp = appTemp->next;
-		}	
-		fprintf(fp, "---END---\n");
-		temp = temp->next;
+//runs a command file against the store, saves it and prints the summary
+int batchMode (Employee ** head, const char * name){
+	BatchReport batch;
+	FILE * fp = (strcmp(name, "-") == 0) ? stdin : fopen(name, "r");
+	if (fp == NULL){
+		printf("NOTE: could not open %s.\n", name);
+		closeStore();
+		return 1;
 	}
-
-	fclose(fp);
-}
-
-void loadAppointments(Appointment **ptr, FILE ** fl){
-	
-	Appointment * head = NULL, *temp = NULL;
-	Appointment *app =NULL;
-	do{
-		time_t now; time (&now);
-		struct tm timestamp = *localtime(&now);
-		struct tm schedule = *localtime(&now);
-		int appMonth, appYear;
-		
-		char line[100], *p;
-		
-		fgets (line, 100, *fl);
-		
-		if(feof(*fl)) printf("END!!\n");
-		
-		if(strcmp(line, "---END---\n")==0){
-			if (head!=NULL){
-			}
-			*ptr = head;
-			
-			break;
-		}
-		
-		app = (Appointment*)malloc(sizeof(Appointment));
-		
-		p=strtok (line, "|");
-		sscanf(p, "%d/%d/%d", &appMonth, &schedule.tm_mday, &appYear);
-		schedule.tm_mon = appMonth-1;
-		schedule.tm_year =(appYear + 2000) -1900;
-		
-		p=strtok (NULL, "|");
-		sscanf(p, "%d:%d", &schedule.tm_hour, &schedule.tm_min);
-		p=strtok (NULL, "|"); 
-		sscanf(p, "%d", &app->id);
-		
-		app->schedule = schedule;
-		
-		char date[30];
-		strftime(date, sizeof(date), "%x", &app->schedule);
-		printf("SCHEDULE: %s\n", date);
-		app->next = NULL;
-		head = addAppointment(head, app);
-		
-		if (head!=NULL){
-				//printf("HEAD->ID %d\n", (*(head))->id);
-			}
-		printf("Inserted new data!\n");
-		
-	} while (1);
-
-	
-}
-
-Employee * loadEmployees (Employee * head, FILE * fp){
-	time_t now; time (&now);
-	struct tm timestamp = *localtime(&now);
-	struct tm schedule = *localtime(&now);
-	int month, year;
-	fp = fopen("employees.txt", "r");
-	int idCounter = 0;
-	if (fp != NULL){
-		char firstLine[100];
-		while (fgets(firstLine, 100, fp) != NULL){
-			Employee * newEmp = (Employee *) malloc(sizeof(Employee));
-			char id[5], age[5], date[30];
-			fgets(newEmp->name.last, 50, fp);
-			fgets(newEmp->name.first, 50, fp);
-			fgets(id, 15, fp);
-			fgets(age, 15, fp);
-			newEmp->age = atoi (age);
-			newEmp->empNum = atoi(id);
-			fgets(newEmp->position, 30, fp);
-			int len = strlen(newEmp->position);
-			if( newEmp->position[len-1] == '\n' )
-				newEmp->position[len-1] = 0;
-			fgets(date, 30, fp);
-			sscanf(date,"%d/%d/%d", &month, &timestamp.tm_mday, &year);
-			timestamp.tm_mon = month - 1;
-			if (year < 50){
-			timestamp.tm_year = (year+2000)-1900; 
-			} else if (year > 50 && year < 100){
-				//timestamp.tm_year = year + 1900;
-			}
-			newEmp->dateHired = timestamp;
-			newEmp->app = NULL;
-			newEmp->next = NULL;
-			head = addEmployee (head, newEmp);
-			//showEmpDetails(newEmp);
-			idCounter++;
-		}
-	} else{}
-	fclose(fp);
-	maxGlobalID = idCounter;
-	return head;
+	runBatch(head, fp, &batch);
+	if (fp != stdin){
+		fclose(fp);
+	}
+	saveFiles(*head);
+	closeStore();
+#ifdef SPA_STATS
+	if (writeStats(STATS_FILE) != SPA_OK){
+		printf("NOTE: could not write %s.\n", STATS_FILE);
+	}
+#endif
+	writeBatchReport(&batch, stdout);
+	return 0;
 }
 
 void printBanner(){
 	printf("\n~~~~~~~~~~~~~~~~~~~~~~~~~~~\n SPA MOMENTS ONLINE PORTAL \n~~~~~~~~~~~~~~~~~~~~~~~~~~~\n");
 }
+
 int showMainMenu(){
 	printBanner();
 	printf("\nChoose a category:\n\n");
 	printf("[1] Employees\n");
 	printf("[2] Appointments\n");
+#ifdef SPA_STATS
+	printf("[3] Statistics\n");
+#endif
 	printf("\n[0] Exit\n\n");
 	
 	int choice;
@@ -321,6 +244,9 @@ int showAppMenu(){
 	printf("[1] Add Appointment\n");
 	printf("[2] Edit Appointment\n");
 	printf("[3] Delete Appointment\n");
+	printf("[4] Find Free Slot\n");
+	printf("[5] View Schedule\n");
+	printf("[6] View Timeline\n");
 	printf("\n [0] Back to main menu\n");
 	int choice;
 	printf("\nEnter choice: ");
@@ -328,53 +254,79 @@ int showAppMenu(){
 	return choice;
 }
 
-
-void generateId (Employee * emp){
-	int EmpNum = maxGlobalID; 
-	int choice;
-	EmpNum++;
-	emp->empNum = EmpNum;
-	maxGlobalID++;
+//reads one line into a name buffer, dropping the newline and anything past NAME_SIZE - 1 characters
+void readName (char * name){
+	int len;
+	if (fgets(name, NAME_SIZE, stdin) == NULL){
+		name[0] = 0;
+		return;
+	}
+	len = strlen(name);
+	if (len > 0 && name[len-1] == '\n'){
+		name[len-1] = 0;
+	} else{
+		scanf("%*[^\n]");
+		scanf("%*c");
+	}
 }
+
 void enterName (Employee * emp){
-	
+	char last[NAME_SIZE], first[NAME_SIZE];
 	char char_buffer;
 	scanf("%c", &char_buffer);
 	printf("Last name: ");
-	fgets(emp->name.last, 50, stdin);
+	readName(last);
 	printf("First name: ");
-	fgets(emp->name.first, 50, stdin);
+	readName(first);
+	setEmpName(emp, last, first);
 }
+
 void enterAge (Employee * emp){
 	int status = ACTIVE;
+	int age;
 	do{
 		printf("Age: ");
-		if (scanf("%d", &emp->age)!=1){
+		if (scanf("%d", &age)!=1){
 			printf("NOTE: Invalid age. \n");
 			scanf("%*s");
+		} else if (age < 0 || age > 255){
+			printf("NOTE: Invalid age. \n");
 		} else{
+			emp->age = age;
 			status=EXITED;
 		}
 	} while (status==ACTIVE);
 	
 }
+
+//the position choices in two numbered columns, from the names the files use
+void showPositions (){
+	int half = (POSITION_COUNT + 1) / 2, i;
+	for (i = 0; i < half; i++){
+		printf("[%d]%-26s", i + 1, positionNames[i]);
+		if (i + half < POSITION_COUNT){
+			printf("[%d]%s", i + half + 1, positionNames[i + half]);
+		}
+		printf("\n");
+	}
+}
+
 void enterPos (Employee * emp){
 	char char_buffer;
 	int choice;
 	scanf("%c", &char_buffer);
 	printf("Available Positions: ");
-	const char positions[8][30] = {"AESTHETICIAN", "HAIR STYLIST", "MASSAGE THERAPIST", "NAIL TECHNICIAN", "SALON SERVICES ATTENDANT", "SPA ATTENDANT", "SPA MANAGEMENT", "SPA RECEPTIONIST"};
 	
 	int status = ACTIVE;
 	do{
 		printf("\n\t\t\tPOSITIONS\n");
-		printf("[1]Aesthetician  \t[5]Salon Services Attendant\n[2]Hair Stylist \t[6]Spa Attendant\n[3]Massage Therapist \t[7]Spa Management \n[4]Nail technician \t[8]Spa Receptionist\n");
+		showPositions();
 		printf("\nEnter valid position: ");
 		if ((scanf("%d", &choice)!=1)){
 			printf("NOTE: Invalid choice. \n");
 			scanf("%*s");
 		} else{
-			if (choice < 1 || choice > 8){
+			if (choice < 1 || choice > POSITION_COUNT){
 				printf("NOTE: Invalid choice. \n");
 			} else{
 			status=EXITED;
@@ -383,16 +335,13 @@ void enterPos (Employee * emp){
 	} while (status==ACTIVE);
 	
 	choice--;
-	strcpy(emp->position, positions[choice]);
+	emp->position = choice;
 	
 }
 
 void enterDateHir (Employee * emp){
-	char date[12];
-	struct tm dateHired;
 	printf("DATE HIRED: ");
-	dateHired = inputDate(emp->dateHired);
-	emp->dateHired=dateHired;
+	setEmpHired(emp, inputDate());
 
 }
 
@@ -443,167 +392,87 @@ int confirmChoice(){
 	
 }
 
-struct tm inputDate (struct tm timestamp){
+int inputDate (){
 	int status=ACTIVE;
-	time_t now;
-	time (&now);
-	
-	timestamp = *localtime(&now);
+	int days = 0;
 	do{
-		time_t app_time_t;
-		struct tm app_tm;
 		char date[20];
-		char myApp[20];
-
 		
 		printf("Enter date (mm/dd/yy): ");
-		scanf("%s", date);
-		int len = strlen(date);
-		int month, year;
-		sscanf(date,"%d/%d/%d", &month, &timestamp.tm_mday, &year);
-		timestamp.tm_mon = month -1;
-		
-			if (year < 50){
-			timestamp.tm_year = (year+2000)-1900; 
-			} else if (year > 50 && year < 100){
-				timestamp.tm_year = year + 1900;
-			}
-		
-		if (mktime(&timestamp)==-1){
+		scanf("%19s", date);
+		if (parseDate(date, &days) == EXITED){
 			printf("Incorrect format. Please try again.\n");
 		} else{
-			app_time_t = mktime(&timestamp);
-			app_tm = *localtime(&app_time_t);
-			strftime(myApp, sizeof(myApp), "%x", &app_tm);
-			if (strcmp(myApp, date) != 0){
-				printf("Incorrect format. Please try again.");
-			} else{
-				status = EXITED;
-			}
-		} 
+			status = EXITED;
+		}
 	}while(status==ACTIVE);
 	
-	return timestamp;
+	return days;
 	
 }
 
-struct tm inputTime (struct tm timestamp){
+int inputTime (){
 	int status=ACTIVE;
+	int minutes = 0;
 	do{
-	time_t app_time_t;
-	struct tm app_tm;
 	char time[10];
-	char myApp[20];
 	
 	printf("Enter time of appointment (hh:mm) (24-hr format): ");
-	scanf("%s", time);
-	sscanf(time, "%d:%d", &timestamp.tm_hour, &timestamp.tm_min);
-	
-		if (mktime(&timestamp)==-1){
+	scanf("%9s", time);
+		if (parseClock(time, &minutes) == EXITED){
 			printf("Incorrect format. Please try again.\n");
-		} else {
-			timestamp.tm_sec = 0; //DO NOT REMOVE!
-			app_time_t = mktime(&timestamp);
-			app_tm = *localtime(&app_time_t);
-			strftime(myApp, sizeof(myApp), "%H:%M", &app_tm);
-			if (strcmp(myApp, time) != 0){
-				printf("Incorrect format. Please try again.");
-			}else{
-				status=EXITED;
-			}
-	
+		} else{
+			status=EXITED;
 		}
 	}while (status == ACTIVE);
 	
-	return timestamp;
+	return minutes;
 }
 
-Employee * createEmployee(){
-	Employee * newEmp = (Employee *) malloc (sizeof(Employee));
+Employee * createEmployee(Employee * head){
+	Employee details, * newEmp = NULL;
 	
 	printf("ENTER NEW EMPLOYEE DETAILS: \n");
 
-	generateId(newEmp);
-	enterName(newEmp);
-	enterAge(newEmp);
-	enterPos(newEmp);
-	enterDateHir(newEmp);
+	enterName(&details);
+	enterAge(&details);
+	enterPos(&details);
+	enterDateHir(&details);
+	STAT_BEGIN(hireStart);
+	hireEmployee(&head, &details, &newEmp);
+	STAT_END(OP_HIRE, hireStart);
 	
-	printf("\nAssigned ID No. %d to Mr./Ms. %s", newEmp->empNum, newEmp->name.last);
-	newEmp->app= NULL;
-	newEmp->next = NULL;
+	printf("\nAssigned ID No. %d to Mr./Ms. %s\n", newEmp->empNum, empLast(newEmp));
 	
 	printf("\n***********************\nNew Recruit Summary\n***********************\n");
 	showEmpDetails(newEmp);
 	printf("************************\n");
 	
-	return newEmp;
-	
+	return head;
 	
-}
-
-int compareNames(Employee * emp1, Employee * emp2){
 	
-	if (strcmp(emp1->name.last, emp2->name.last) != 0){
-		return strcmp(emp1->name.last, emp2->name.last);
-	} else {
-		return strcmp(emp1->name.first, emp2->name.first);
-	}
-
 }
 
-
-Employee * addEmployee(Employee * head, Employee * newEmp){
-	if (newEmp == NULL){
-		newEmp = createEmployee();
-	}
-	
-	Employee * temp = NULL;
-	temp = head;
-
-	
-	if (head == NULL|| compareNames(newEmp, head) <0){ //insert at head
-		newEmp->next = head;
-		head = newEmp;
-	}
-	else{
-		while (temp->next!=NULL && compareNames(newEmp, temp->next) >0){
-			temp = temp->next;
-		}
-		if (temp->next == NULL){ //add at tail
-			newEmp->next = NULL;
-			temp->next = newEmp;
-		} else{ //add at middle
-			newEmp -> next = temp->next;
-			temp->next = newEmp;
-		}
-
-
-	}
-	
-
-	return head;
-}
-	
-void editEmployee(Employee * head){
+Employee * editEmployee(Employee * head){
 	int empNum = enterEmpNum();
 	Employee * emp = findEmp(head, empNum);
 	if (emp != NULL){
 		int status = ACTIVE;
 		int choice;
+		Employee details = *emp; //edited here, then applied in one step
 		while (status == ACTIVE){
 			
 			printf("\n[1]Name\n[2]Age\n[3]Position\n[0]Exit\nSelect entry to be edited: ");
 			scanf("%d", &choice);
 			switch(choice){
 				case 1:
-					enterName(emp);
+					enterName(&details);
 					break;
 				case 2:
-					enterAge(emp);
+					enterAge(&details);
 					break;
 				case 3:
-					enterPos(emp);
+					enterPos(&details);
 					break;
 				case 0:
 					status = EXITED;
@@ -613,72 +482,39 @@ void editEmployee(Employee * head){
 					break;
 			}
 		}
+		STAT_BEGIN(editStart);
+		changeEmployee(&head, empNum, &details);
+		STAT_END(OP_EDIT_EMP, editStart);
 	} else{
 		printf("Employee does not exist.");
 	}
+	return head;
 }
 
-
 Employee * delEmpByNum (Employee * head){
 	viewAllEmps(head);
 	printf("\n>>Delete employee info...");
 	int empNum = enterEmpNum();
-	Employee * temp;
-	temp = head;
+	Employee * emp = findEmp(head, empNum);
 	
-	if (temp!=NULL && temp->empNum == empNum){
-		printf("Are you sure you want to delete the following employee data? (Y/N): ");
-		showEmpDetails(temp);
-		
-		int confirm = confirmChoice();
-		if (confirm == ACTIVE){
-				head = temp-> next;
-				free (temp);
-				printf("\n>>Successfully deleted.\n");
-				return head; 
-
-		} else{
-			printf("\n>>...\n");
-			return head;
-		}
-	} else{
-		while(temp!=NULL && temp->next!=NULL && temp->next->empNum != empNum){
-			temp = temp -> next;
-		}
-
-		if (temp == NULL || temp->next==NULL){
-			printf("Employee does not exist.");
-			return head;
-		}else{
-			printf("Are you sure you want to delete the following employee data? (Y/N): ");
-			showEmpDetails(temp->next);
-		
-			int confirm = confirmChoice();
-			if (confirm == ACTIVE){
-					Employee * del = temp -> next;
-					temp->next = temp->next->next;
-					free(del);
-					printf("\n>>Successfully deleted.\n");
-					return head; 
-			} else{
-				printf("\n>>...\n");
-				return head;
-			}
-		}	
+	if (emp == NULL){
+		printf("Employee does not exist.");
+		return head;
 	}
-}
-
-Employee * delAllEmps (Employee * head){
-	Employee * temp;
-	temp = head;
 	
-	if (temp == NULL){
-		return head;
+	printf("Are you sure you want to delete the following employee data? (Y/N): ");
+	showEmpDetails(emp);
+		
+	int confirm = confirmChoice();
+	if (confirm == ACTIVE){
+		STAT_BEGIN(fireStart);
+		fireEmployee(&head, empNum);
+		STAT_END(OP_FIRE, fireStart);
+		printf("\n>>Successfully deleted.\n");
 	} else{
-		head = temp-> next;
-		free (temp);
-		return delAllEmps(head);
+		printf("\n>>...\n");
 	}
+	return head;
 }
 
 Employee * delEmployee(Employee * head){
@@ -695,7 +531,9 @@ Employee * delEmployee(Employee * head){
 		int confirm = confirmChoice();
 		if (confirm == ACTIVE){
 			printf(">>Deleting all employees");
-			head = delAllEmps (head);
+			STAT_BEGIN(fireStart);
+			fireAllEmployees(&head);
+			STAT_END(OP_FIRE, fireStart);
 		} else{
 			printf(">>...");
 		}
@@ -704,68 +542,39 @@ Employee * delEmployee(Employee * head){
 		printf("Please pick a valid option.");
 	}
 }
+	return head;
 }
 
-
 void viewAllEmps(Employee * head){
+	STAT_BEGIN(viewStart);
 	printBanner();
 	Employee * temp = NULL;
 	temp = head;
-	char full_name[30];
 	printf("\n-------------------------\nFULL LIST OF EMPLOYEES\n-------------------------\n");
 	while (temp!=NULL){
-		printf("Surname: %s", temp->name.last);
-		printf("Given Name: %s", temp->name.first);
+		STAT_ADD(STAT_NODES, 1);
+		printf("Surname: %s\n", empLast(temp));
+		printf("Given Name: %s\n", empFirst(temp));
 		printf("Employee Number: %d\n", temp->empNum);
 		printf("Age: %d\n", temp->age);
-		printf("Position: %s\n", temp->position);
+		printf("Position: %s\n", positionNames[temp->position]);
 		char date[30];
-		strftime(date, sizeof(date), "%x", &temp->dateHired);
+		formatDate(date, empHired(temp));
 		printf("Date Hired: %s\n\n", date);
-		//printf("TEMP->NEXT->NAME.last = %s", temp->next->name.last); 
 		temp = temp->next;
 	}
-}
-
-Employee * findEmp (Employee * head, int empNum){
-	Employee * emp = NULL;
-	emp = head;
-
-	while (emp!=NULL && emp->empNum!=empNum){
-		emp = emp->next;
-	}
-	
-	return emp;
-	
-}
-
-Employee * findBookedEmp (Employee * head, int appId){
-	Employee * emp = NULL;
-	emp = head;
-	Appointment * app = NULL;
-	while (emp!=NULL){
-		app = emp->app;
-		while (app!=NULL && app->id!=appId){
-			app=app->next;
-
-		}
-		if (app!=NULL){
-			return emp;
-		}
-		emp = emp->next;
-	}
-	return emp;
+	STAT_END(OP_VIEW, viewStart);
 }
 
 void showEmpDetails (Employee * emp){
 	if (emp!=NULL){
-		printf("\nSurname: %s", emp->name.last);
-		printf("Given Name: %s", emp->name.first);
+		printf("\nSurname: %s\n", empLast(emp));
+		printf("Given Name: %s\n", empFirst(emp));
 		printf("\nEmployee Number: %d\n", emp->empNum);
 		printf("Age: %d\n", emp->age);
-		printf("Position: %s\n", emp->position);
+		printf("Position: %s\n", positionNames[emp->position]);
 		char date[12];
-		strftime(date, sizeof(date), "%x", &emp->dateHired);
+		formatDate(date, empHired(emp));
 		printf("Date Hired : %s\n", date);
 	}
 	else{
@@ -773,47 +582,75 @@ void showEmpDetails (Employee * emp){
 	}
 }
 
-
 void viewEmpByNum(Employee * head){
 	Employee * emp;
 	int empNum = enterEmpNum();
+	STAT_BEGIN(viewStart);
 	emp = findEmp (head, empNum);
 	showEmpDetails (emp);
 	showApps (emp);
+	STAT_END(OP_VIEW, viewStart);
 }
 
 void viewByPosition(Employee * head){
 	Employee * temp = NULL;
-	temp = head;
+	(void) head; //the position buckets are walked instead
 	
 	printf("Enter position: \n");
-	printf("[1]Aesthetician  \t[5]Salon Services Attendant\n[2]Hair Stylist \t[6]Spa Attendant\n[3]Massage Therapist \t[7]Spa Management \n[4]Nail technician \t[8]Spa Receptionist\n");
-	char positions[8][30] = {"AESTHETICIAN", "HAIR STYLIST", "MASSAGE THERAPIST", "NAIL TECHNICIAN", "SALON SERVICES ATTENDANT"," SPA ATTENDANT", "SPA MANAGEMENT", "SPA RECEPTIONIST"};
+	showPositions();
 	int choice;
-	scanf ("%d", &choice);
+	if (scanf ("%d", &choice)!=1 || choice < 1 || choice > POSITION_COUNT){
+		scanf("%*[^\n]");
+		printf("NOTE: Invalid choice. \n");
+		return;
+	}
 	choice--;
-	char position [30]; 
-	strcpy(position, positions[choice]);
-	printf("Viewing all: %s\n", position);
+	STAT_BEGIN(viewStart);
+	printf("Viewing all: %s\n", positionNames[choice]);
 
+	//only the employees filed under this position are visited
+	temp = posHead[choice];
 	while (temp!=NULL){
-		if (strcmp(temp->position, position)== 0){
-			
-			printf("\nEmployee Number: %d\n", temp->empNum);
-			printf("Surname: %s", temp->name.first);
-			printf("First Name: %s", temp->name.last);
-			printf("Age: %d\n", temp->age);
-			printf("Position: %s\n", temp->position);
-			printf("Date Hired : %d/%d/%d\n", temp->dateHired.tm_mon,temp->dateHired.tm_mday, temp->dateHired.tm_year);
-		}
-		temp = temp->next;
+		STAT_ADD(STAT_NODES, 1);
+		printf("\nEmployee Number: %d\n", temp->empNum);
+		printf("Surname: %s\n", empLast(temp));
+		printf("First Name: %s\n", empFirst(temp));
+		printf("Age: %d\n", temp->age);
+		printf("Position: %s\n", positionNames[temp->position]);
+		char date[12];
+		formatDate(date, empHired(temp));
+		printf("Date Hired : %s\n", date);
+		temp = temp->posNext;
 	}
+	STAT_END(OP_VIEW, viewStart);
 
 }
 
+void viewBySurname(Employee * head){
+	char prefix[20];
+	(void) head; //searched through the name tree
+	printf("Enter the first letters of the surname: ");
+	if (scanf("%19s", prefix)!=1){
+		return;
+	}
+	
+	//matches are contiguous in name order, so the walk stops at the first non-match
+	STAT_BEGIN(viewStart);
+	Employee * temp = findBySurname(prefix);
+	int count = 0;
+	while (temp!=NULL && strncmp(empLast(temp), prefix, strlen(prefix)) == 0){
+		STAT_ADD(STAT_NODES, 1);
+		showEmpDetails(temp);
+		count++;
+		temp = temp->next;
+	}
+	printf("\n%d employee(s) found.\n", count);
+	STAT_END(OP_VIEW, viewStart);
+}
+
 void viewEmployee(Employee * head){
 	while (ACTIVE){
-		printf("\n[1] View one employee\n[2] View all employees\n[3] View by position\n");
+		printf("\n[1] View one employee\n[2] View all employees\n[3] View by position\n[4] Find by surname\n");
 		printf("Enter option: ");
 		int choice;
 		scanf ("%d", &choice);
@@ -827,141 +664,79 @@ void viewEmployee(Employee * head){
 		} else if (choice == 3){
 			viewByPosition(head);
 			break; 
+		} else if (choice == 4){
+			viewBySurname(head);
+			break;
 		} else{
 			printf("Please pick a valid option.");
 		}
 	}
 }
 
-int generateAppId(){
-		static int id = 1; 
-		int genId = id;
-		id++;
-		
-		return genId;
-		
-}
-Appointment * createAppointment (){
-
-	int id = generateAppId();
-	Appointment * newApp = (Appointment * ) malloc (sizeof(Appointment)); 
-	newApp->id = id;
-	newApp->next = NULL;
-	
+int inputLength (){
+	int minutes;
 	int status = ACTIVE;
-	
-	struct tm timestamp;
-	
-	timestamp = inputDate(timestamp);
-	timestamp = inputTime(timestamp);
-
-	newApp->schedule = timestamp;
-
-	return newApp;
-	
-	
+	do{
+		printf("Length of appointment in minutes (e.g. 30, 60, 90): ");
+		if (scanf("%d", &minutes)!=1){
+			printf("NOTE: Invalid length. \n");
+			scanf("%*s");
+		} else if (minutes <= 0 || minutes > MAX_APP_MINUTES){
+			printf("NOTE: Length must be between 1 and %d minutes. \n", MAX_APP_MINUTES);
+		} else{
+			status = EXITED;
+		}
+	} while (status == ACTIVE);
+	return minutes * 60;
 }
 
-
 void showApps(Employee * emp){
 	if(emp!=NULL){
 		Appointment * temp = emp->app;		
 		while (temp!=NULL){
+			STAT_ADD(STAT_NODES, 1);
 			char appString [30];
-			strftime(appString, sizeof(appString), "%x at %I:%M%p", &temp->schedule);
-			printf("ID No.: %d | Schedule: %s\n", temp->id, appString);
+			formatSchedule(appString, temp->start);
+			printf("ID No.: %d | Schedule: %s | %d min\n", temp->id, appString, temp->length / 60);
 			temp = temp->next;
 		}
 	}
 }
 
-int checkAppointment (Appointment * head, Appointment * newApp){
-		Appointment * temp = NULL;
-		char appString[30];
-		temp = head;
-		
-		printf("Hello world!");
-		
-		if (difftime(mktime(&newApp->schedule), mktime(&temp->schedule)) >-1800 && difftime(mktime(&newApp->schedule), mktime(&temp->schedule)) <1800){
-				printf("Proposed appointment conflicts with existing appointment: ID No. %d", head->id);
-				return 0;
-		}else{
-			while (temp->next!=NULL && difftime(mktime(&newApp->schedule), mktime(&temp->schedule))> 1800){
-				temp = temp->next;
-			} if (difftime(mktime(&newApp->schedule), mktime(&temp->schedule)) > -1800 && difftime(mktime(&newApp->schedule), mktime(&temp->schedule)) <1800){
-				printf("Proposed appointment conflicts with existing appointment: ID No. %d", temp->id);
-				return 0;
-			}
-		return 1;
-	}
-}
+void addAppointment(Employee * emp){
+		int days = inputDate();
+		int minutes = inputTime();
+		int length = inputLength();
+		int id;
 
-Appointment * addAppointment(Appointment * head, Appointment * app){
-		static int isLoadingFile = 0;
-		Appointment * newApp;
-		if (head!=NULL){
-		printf("head->id %d\n", head->id);
-		}
-		if (app == NULL){
-			newApp = createAppointment();
-		} else{
-			Appointment newAppInfo = *app;
-			newApp = &newAppInfo;
-		}
-
-		Appointment * temp = NULL;
 		char appString[30];
-		temp = head;
-		if (head == NULL || difftime(mktime(&newApp->schedule), mktime(&head->schedule)) <= -1800){
-			newApp->next = head;
-			head = newApp;
-
-		} else if (difftime(mktime(&newApp->schedule), mktime(&temp->schedule)) >-1800 && difftime(mktime(&newApp->schedule), mktime(&temp->schedule)) <1800){
-				printf("Proposed appointment conflicts with existing appointment: ID No. %d\n", head->id);
-				newApp->id = -1;
-				return head;
-		}else{
-			while (temp->next!=NULL && difftime(mktime(&newApp->schedule), mktime(&temp->schedule))> 1800){
-				temp = temp->next;
-			} if (difftime(mktime(&newApp->schedule), mktime(&temp->schedule)) > -1800 && difftime(mktime(&newApp->schedule), mktime(&temp->schedule)) <1800){
-				printf("Proposed appointment conflicts with existing appointment: ID No. %d\n", temp->id);
-				newApp->id = -1;
-				return head;
-			}
-			 else if (temp->next == NULL){ //add at tail	
-				newApp->next = NULL;
-				temp->next = newApp;
-			}else{ //add at middle
-				newApp -> next = temp->next;
-				temp->next = newApp;
-			}
+		time_t start = localToTime(days, minutes);
+		STAT_BEGIN(bookStart);
+		int status = bookAppointment(emp, start, length, &id);
+		STAT_END(OP_BOOK, bookStart);
+		if (status == SPA_CONFLICT){
+			printf("Proposed appointment conflicts with existing appointment: ID No. %d\n", id);
+			return;
+		}
 
-	}
-	if (isLoadingFile == 0){
 		//ON SUCCESS SCHEDULING OF APPOINTMENT
-		strftime(appString, sizeof(appString), "%x at %I:%M%p", &newApp->schedule);
-		printf("You have scheduled an appointment on %s with Appointment ID no. %d\n", appString, newApp->id);
-	} else{
-		isLoadingFile = 0;
-	}
-	return head;
+		formatSchedule(appString, start);
+		printf("You have scheduled an appointment on %s with Appointment ID no. %d\n", appString, id);
 
 }
 
-Appointment * findAppointment (Appointment * appHead, int id){
-	Appointment * app = NULL;
-	app = appHead;
-	while (app!=NULL && app->id!=id){
-		app = app->next;
-	}
-	
-	return app;
-	
+//rescheduleAppointment, timed as an appointment edit; the arguments are read before the clock starts
+int moveAppointment (Appointment * app, Employee * emp, time_t start, int id, int * conflictId){
+	STAT_BEGIN(moveStart);
+	int status = rescheduleAppointment(app, emp, start, id, conflictId);
+	STAT_END(OP_EDIT_APP, moveStart);
+	return status;
 }
-Employee * editAppointment(Employee * head, Appointment * appHead, int id){
-	Appointment * app = findAppointment (appHead, id);
+
+Employee * editAppointment(Employee * head, int id){
+	Appointment * app = findAppointment (id);
 	if (app!=NULL){
-		int choice, status;
+		int choice, status = ACTIVE;
 		showAppDetails(app);
 		printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n");
 		do{
@@ -972,65 +747,37 @@ Employee * editAppointment(Employee * head, Appointment * appHead, int id){
 				printf("NOTE: Invalid choice. \n");
 				scanf("%*s");
 			} else{
-				time_t now;
-				time (&now);
-				struct tm newSched = *localtime(&now);
-				Appointment oldApp, newApp;
+				int oldDay, oldMinutes, conflictId;
+				timeToLocal(app->start, &oldDay, &oldMinutes);
 				Employee * emp = NULL;
 
 				switch (choice){
 					case 1:
-						oldApp = *app;
-						newApp = *app;
-						head = delAppointment (head, app->id);
-						newSched = inputDate(newSched);
-						newSched.tm_hour = app->schedule.tm_hour;
-						newSched.tm_min = app->schedule.tm_min;
-						newApp.schedule = newSched;
-						newApp.id = generateAppId();
-						appHead = addAppointment(appHead, &newApp);
-						if (newApp.id!=-1){
-							//head = delAppointment (head, app->id);
+						if (moveAppointment(app, app->owner, localToTime(inputDate(), oldMinutes), app->id, &conflictId) == SPA_OK){
 							printf("\nDate successfully updated\n");
 						} else{
-							appHead = addAppointment (appHead, &oldApp);
+							printf("Proposed appointment conflicts with existing appointment: ID No. %d\n", conflictId);
 							printf("Please schedule at another time.");
-							}
+						}
 						break;
 					case 2:
-					//MODIFY ID! Remember!
-						oldApp = *app;
-						newApp = *app;
-						head = delAppointment (head, app->id);
-						newSched = inputTime(newSched);
-						newSched.tm_mday = app->schedule.tm_mday;
-						newSched.tm_mon = app->schedule.tm_mon;
-						newSched.tm_year = app->schedule.tm_year;
-						newApp.schedule = newSched;
-						newApp.id = generateAppId();
-						appHead = addAppointment(appHead, &newApp);
-						if (newApp.id!=-1){
-							//head = delAppointment (head, app->id);
+						if (moveAppointment(app, app->owner, localToTime(oldDay, inputTime()), app->id, &conflictId) == SPA_OK){
 							printf("\nTime successfully updated\n");
 						} else{
-							appHead = addAppointment (appHead, &oldApp);
+							printf("Proposed appointment conflicts with existing appointment: ID No. %d\n", conflictId);
 							printf("Please schedule at another time.");
 						}
 						break;
 					case 3:
 						viewAllEmps(head);
 						printf("Enter new employee: \n");
-						int choice; 
 						choice = enterEmpNum(head);
 						emp = findEmp(head, choice);
 						if (emp!=NULL){
-							Appointment * appHead = emp->app;
-							Appointment newApp = *app;
-							appHead = addAppointment(appHead, &newApp);
-							if (newApp.id!=-1){
-								head = delAppointment (head, app->id);
+							if (moveAppointment(app, emp, app->start, app->id, &conflictId) == SPA_OK){
 								printf("\nEmployee assigned successfully updated\n");
 							} else{
+								printf("Proposed appointment conflicts with existing appointment: ID No. %d\n", conflictId);
 								printf("Please schedule at another time.");
 							}
 						} else{
@@ -1051,72 +798,140 @@ Employee * editAppointment(Employee * head, Appointment * appHead, int id){
 }
 
 Employee * delAppointment(Employee * head, int id){
-	Employee * emp = head;
-	int success = 0;
+	Appointment * app = findAppointment(id);
 	
-	while (emp != NULL && success == 0){
-		Appointment * appHead = emp->app;
-		Appointment * temp;
-		
-		temp = appHead;
+	if (app == NULL){
+		printf("Appointment does not exist!");
+		return head;
+	}
 	
-		if (temp!=NULL && temp->id == id){
-			printf("Please confirm the requested action on the following appointment (Y/N): ");
-			showAppDetails(temp);
+	printf("Please confirm the requested action on the following appointment (Y/N): ");
+	showAppDetails(app);
 			
-			int confirm = confirmChoice();
-			if (confirm == ACTIVE){
-					emp->app = NULL;
-					free (temp);
-					printf("\n>>Confirmed.\n");
-					success = ACTIVE;
-					break;
+	int confirm = confirmChoice();
+	if (confirm == ACTIVE){
+		STAT_BEGIN(cancelStart);
+		cancelAppointment(id);
+		STAT_END(OP_CANCEL, cancelStart);
+		printf("\n>>Confirmed.\n");
+	} else{
+		printf("\n>>...\n");
+	}
+	return head;
+}
 
-			} else{
-				printf("\n>>...\n");
-				success = ACTIVE;
-				break;
-			}
-		} else{
-			while(temp!=NULL && temp->next!=NULL && temp->next->id != id){
-				temp = temp -> next;
-			}
-			
-			if (temp == NULL || temp->next==NULL){
-			}else{
-				printf("Please confirm the requested action on the following appointment (Y/N): ");
-				showAppDetails(temp->next);
-			
-				int confirm = confirmChoice();
-				if (confirm == ACTIVE){
-						Appointment * del = temp->next;
-						temp->next = temp->next->next;
-						free(del);
-						printf("\n>>Confirmed.\n");
-						success = ACTIVE; 
-						break;
-				} else{
-					printf("\n>>...\n");
-					success = ACTIVE;
-					break;
-				}
+//lists the earliest free slots with anyone in a position, for a walk-in, and books one if asked
+void bookFreeSlot(){
+	FreeSlot slots[FREE_SLOTS_SHOWN];
+	int found, choice, id, i;
 	
+	printf("Enter position: \n");
+	showPositions();
+	int position;
+	if (scanf ("%d", &position)!=1 || position < 1 || position > POSITION_COUNT){
+		scanf("%*[^\n]");
+		printf("NOTE: Invalid choice. \n");
+		return;
+	}
+	printf("Earliest time wanted:\n");
+	int days = inputDate();
+	int minutes = inputTime();
+	int length = inputLength();
+	STAT_BEGIN(viewStart);
+	findFreeSlots(position - 1, localToTime(days, minutes), length, FREE_SLOTS_SHOWN, slots, &found);
+	STAT_END(OP_VIEW, viewStart);
+	if (found == 0){
+		printf("No %s is free between %02d:00 and %02d:00 in the next %d days.\n", positionNames[position - 1], SEARCH_OPEN / 60, SEARCH_CLOSE / 60, SEARCH_DAYS);
+		return;
+	}
+	for (i = 0; i < found; i++){
+		char appString[30];
+		formatSchedule(appString, slots[i].start);
+		printf("[%d] %s with %s, %s (ID No. %d)\n", i + 1, appString, empLast(slots[i].emp), empFirst(slots[i].emp), slots[i].emp->empNum);
+	}
+	printf("Book which slot? (0 for none): ");
+	if (scanf("%d", &choice)!=1 || choice < 1 || choice > found){
+		scanf("%*[^\n]");
+		printf("\n>>...\n");
+		return;
+	}
+	STAT_BEGIN(bookStart);
+	int status = bookAppointment(slots[choice - 1].emp, slots[choice - 1].start, length, &id);
+	STAT_END(OP_BOOK, bookStart);
+	if (status == SPA_OK){
+		char appString[30];
+		formatSchedule(appString, slots[choice - 1].start);
+		printf("You have scheduled an appointment on %s with Appointment ID no. %d\n", appString, id);
+	}
+}
+
+//every employee's appointments on one day or the seven days from it, in time order
+void viewSchedule(){
+	while (ACTIVE){
+		printf("\n[1] One day\n[2] One week\n");
+		printf("Enter option: ");
+		int choice;
+		scanf ("%d", &choice);
+		if (choice == 1 || choice == 2){
+			int days = inputDate(), i;
+			STAT_BEGIN(viewStart);
+			printBanner();
+			for (i = 0; i < ((choice == 1) ? 1 : 7); i++){
+				showDay(days + i);
 			}
+			STAT_END(OP_VIEW, viewStart);
+			break;
+		} else{
+			printf("Please pick a valid option.");
 		}
-		emp = emp -> next;
 	}
-		
-	if (success == 0){
-		printf("Appointment does not exist!");
+}
+
+void showDay (int day){
+	Appointment ** apps;
+	int count = findDayApps(day, &apps), i;
+	char date[12];
+	formatDate(date, day);
+	printf("\n-------------------------\nSCHEDULE FOR %s\n-------------------------\n", date);
+	if (count == 0){
+		printf("No appointments.\n");
+	}
+	for (i = 0; i < count; i++){
+		Employee * emp = apps[i]->owner;
+		char appString [30];
+		STAT_ADD(STAT_NODES, 1);
+		formatSchedule(appString, apps[i]->start);
+		printf("ID No.: %d | Schedule: %s | %d min | %s, %s (Employee No. %d)\n", apps[i]->id, appString, apps[i]->length / 60, empLast(emp), empFirst(emp), emp->empNum);
 	}
-	return head;
 }
-		
+
+//every appointment running at some point between two times, all employees together, oldest first
+void viewTimeline(){
+	RangeIter it;
+	Appointment * app;
+	printf("From:\n");
+	int fromDays = inputDate();
+	int fromMinutes = inputTime();
+	printf("To:\n");
+	int toDays = inputDate();
+	int toMinutes = inputTime();
+	STAT_BEGIN(viewStart);
+	printBanner();
+	printf("\n-------------------------\nTIMELINE\n-------------------------\n");
+	openRange(&it, localToTime(fromDays, fromMinutes), localToTime(toDays, toMinutes));
+	while ((app = nextInRange(&it))!=NULL){
+		char appString [30];
+		STAT_ADD(STAT_NODES, 1);
+		formatSchedule(appString, app->start);
+		printf("ID No.: %d | Schedule: %s | %d min | %s, %s (Employee No. %d)\n", app->id, appString, app->length / 60, empLast(app->owner), empFirst(app->owner), app->owner->empNum);
+	}
+	closeRange(&it);
+	STAT_END(OP_VIEW, viewStart);
+}
 
 void showAppDetails (Appointment * app){
 	char appString [30];
-	strftime(appString, sizeof(appString), "%x at %I:%M%p", &app->schedule);
-	printf("ID No.: %d | Schedule: %s\n", app->id, appString);
+	formatSchedule(appString, app->start);
+	printf("ID No.: %d | Schedule: %s | %d min\n", app->id, appString, app->length / 60);
 	
 }
-
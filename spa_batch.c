@@ -0,0 +1,324 @@
+/*
+
+Spa Employee System - batch commands
+
+Parses the command lines described in spa_batch.h and runs them against the store through
+the core operations, with no prompts and nothing printed per record. Used by the batch
+mode of the menu program.
+
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "spa_batch.h"
+#define MAX_FIELDS 8
+#define BOOK_RUN 65536 //consecutive book lines handed to bookAppointments() at once
+
+const char * const commandNames[COMMAND_COUNT] = {"hire", "edit", "fire", "fireall", "book", "reschedule", "reassign", "cancel", "save"};
+
+//field functions
+int parseDetails (char ** fields, Command * cmd);
+double batchClock ();
+
+//batch functions
+void tallyLine (BatchReport * report, int type, int status, int lineNum);
+void runBookings (Employee * head, Booking * bookings, int * lineNums, int count, BatchReport * report);
+
+//cuts line at each '|' and at the end of line; returns the number of fields
+int splitFields (char * line, char ** fields, int max){
+	int count = 0;
+	line[strcspn(line, "\r\n")] = 0;
+	while (count < max){
+		fields[count++] = line;
+		line = strchr(line, '|');
+		if (line == NULL){
+			return count;
+		}
+		*line++ = 0;
+	}
+	return max + 1; //too many
+}
+
+//whole-field decimal number
+int parseNumber (const char * text, int * value){
+	char * end;
+	long n = strtol(text, &end, 10);
+	if (end == text || *end != 0 || n < -2147483647L || n > 2147483647L){
+		return EXITED;
+	}
+	*value = (int) n;
+	return ACTIVE;
+}
+
+//Last|First|age|POSITION; the names are only copied here and interned by runCommand()
+int parseDetails (char ** fields, Command * cmd){
+	int age, i;
+	if (fields[0][0] == 0 || strlen(fields[0]) >= NAME_SIZE || strlen(fields[1]) >= NAME_SIZE){
+		return EXITED;
+	}
+	if (parseNumber(fields[2], &age) == EXITED || age < 0 || age > 255){
+		return EXITED;
+	}
+	for (i = 0; fields[3][i] != 0; i++){
+		fields[3][i] = toupper((unsigned char) fields[3][i]);
+	}
+	cmd->details.position = findPosition(fields[3]);
+	if (cmd->details.position == POS_NONE){
+		return EXITED;
+	}
+	strcpy(cmd->last, fields[0]);
+	strcpy(cmd->first, fields[1]);
+	cmd->details.age = age;
+	return ACTIVE;
+}
+
+//fills cmd from one command line, which is cut up in place; SPA_INVALID when a field is wrong,
+//with cmd->type CMD_NONE when the command itself is unknown
+int parseCommand (char * line, Command * cmd){
+	char * fields[MAX_FIELDS];
+	int count = splitFields(line, fields, MAX_FIELDS);
+	int ok = EXITED;
+	memset(cmd, 0, sizeof(Command));
+	for (cmd->type = 0; cmd->type < COMMAND_COUNT; cmd->type++){
+		if (strcmp(fields[0], commandNames[cmd->type]) == 0){
+			break;
+		}
+	}
+	switch (cmd->type){
+		case CMD_HIRE:
+			ok = count == 6 && parseDetails(fields + 1, cmd) && parseDate(fields[5], &cmd->days);
+			setEmpHired(&cmd->details, cmd->days);
+			break;
+		case CMD_EDIT:
+			ok = (count == 6 || count == 7) && parseNumber(fields[1], &cmd->empNum) && parseDetails(fields + 2, cmd);
+			if (ok && count == 7){
+				ok = parseDate(fields[6], &cmd->days);
+				cmd->hasHired = ACTIVE;
+				setEmpHired(&cmd->details, cmd->days);
+			}
+			break;
+		case CMD_FIRE:
+			ok = count == 2 && parseNumber(fields[1], &cmd->empNum);
+			break;
+		case CMD_FIRE_ALL:
+		case CMD_SAVE:
+			ok = count == 1;
+			break;
+		case CMD_BOOK:
+			ok = count == 5 && parseNumber(fields[1], &cmd->empNum) && parseDate(fields[2], &cmd->days)
+				&& parseClock(fields[3], &cmd->minutes) && parseNumber(fields[4], &cmd->length)
+				&& cmd->length > 0 && cmd->length <= MAX_APP_MINUTES;
+			cmd->length *= 60;
+			break;
+		case CMD_RESCHEDULE:
+			ok = count == 4 && parseNumber(fields[1], &cmd->appId) && parseDate(fields[2], &cmd->days)
+				&& parseClock(fields[3], &cmd->minutes);
+			break;
+		case CMD_REASSIGN:
+			ok = count == 3 && parseNumber(fields[1], &cmd->appId) && parseNumber(fields[2], &cmd->empNum);
+			break;
+		case CMD_CANCEL:
+			ok = count == 2 && parseNumber(fields[1], &cmd->appId);
+			break;
+		default:
+			cmd->type = CMD_NONE;
+	}
+	return ok ? SPA_OK : SPA_INVALID;
+}
+
+//runs a parsed command; result (if given) gets its status and the ID it produced
+int runCommand (Employee ** head, Command * cmd, CommandResult * result){
+	int status = SPA_INVALID, id = 0;
+	Employee * emp = NULL;
+	Appointment * app = NULL;
+	switch (cmd->type){
+		case CMD_HIRE:
+			setEmpName(&cmd->details, cmd->last, cmd->first);
+			status = hireEmployee(head, &cmd->details, &emp);
+			if (status == SPA_OK){
+				id = emp->empNum;
+			}
+			break;
+		case CMD_EDIT:
+			setEmpName(&cmd->details, cmd->last, cmd->first);
+			emp = findEmp(*head, cmd->empNum);
+			if (emp!=NULL && !cmd->hasHired){
+				setEmpHired(&cmd->details, empHired(emp));
+			}
+			status = changeEmployee(head, cmd->empNum, &cmd->details);
+			id = cmd->empNum;
+			break;
+		case CMD_FIRE:
+			status = fireEmployee(head, cmd->empNum);
+			break;
+		case CMD_FIRE_ALL:
+			status = fireAllEmployees(head);
+			break;
+		case CMD_BOOK:
+			status = bookAppointment(findEmp(*head, cmd->empNum), localToTime(cmd->days, cmd->minutes), cmd->length, &id);
+			break;
+		case CMD_RESCHEDULE:
+		case CMD_REASSIGN:
+			app = findAppointment(cmd->appId);
+			if (cmd->type == CMD_REASSIGN){
+				emp = findEmp(*head, cmd->empNum);
+			} else if (app!=NULL){
+				emp = app->owner;
+			}
+			if (app == NULL || emp == NULL){
+				status = SPA_NOT_FOUND;
+			} else{
+				status = rescheduleAppointment(app, emp, (cmd->type == CMD_REASSIGN) ? app->start : localToTime(cmd->days, cmd->minutes), app->id, &id);
+				if (status == SPA_OK){
+					id = app->id;
+				}
+			}
+			break;
+		case CMD_CANCEL:
+			status = cancelAppointment(cmd->appId);
+			break;
+		case CMD_SAVE:
+			status = saveStore(*head);
+			break;
+	}
+	if (result!=NULL){
+		result->type = cmd->type;
+		result->status = status;
+		result->id = id;
+	}
+	return status;
+}
+
+double batchClock (){
+	struct timespec ts;
+#ifdef _WIN32
+	timespec_get(&ts, TIME_UTC);
+#else
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void tallyLine (BatchReport * report, int type, int status, int lineNum){
+	report->lines++;
+	if (type == CMD_NONE){
+		report->unparsed++;
+	} else if (status == SPA_OK){
+		report->ok[type]++;
+	} else{
+		report->failed[type]++;
+	}
+	if (status != SPA_OK && report->errorCount < BATCH_ERRORS){
+		report->errorLine[report->errorCount] = lineNum;
+		report->errorStatus[report->errorCount] = status;
+		report->errorCount++;
+	}
+}
+
+//books a run of consecutive book lines in one pass and tallies them in line order
+void runBookings (Employee * head, Booking * bookings, int * lineNums, int count, BatchReport * report){
+	int i;
+	bookAppointments(head, bookings, count);
+	for (i = 0; i < count; i++){
+		tallyLine(report, CMD_BOOK, bookings[i].status, lineNums[i]);
+	}
+}
+
+//runs every command in fp and tallies the outcomes; a failed line does not stop the batch.
+//Runs of book lines are gathered and booked together, with the same results line by line.
+int runBatch (Employee ** head, FILE * fp, BatchReport * report){
+	char line[COMMAND_SIZE];
+	int lineNum = 0, pending = 0;
+	Booking * bookings = (Booking *) malloc(BOOK_RUN * sizeof(Booking));
+	int * bookLines = (int *) malloc(BOOK_RUN * sizeof(int));
+	double start = batchClock();
+	memset(report, 0, sizeof(BatchReport));
+	while (fgets(line, sizeof(line), fp)!=NULL){
+		Command cmd;
+		int status;
+		lineNum++;
+		if (strchr(line, '\n') == NULL && !feof(fp)){
+			//longer than any valid command: skip the rest and report it
+			int c;
+			while ((c = fgetc(fp)) != EOF && c != '\n');
+			cmd.type = CMD_NONE;
+			status = SPA_INVALID;
+		} else{
+			char * p = line;
+			while (*p == ' ' || *p == '\t'){
+				p++;
+			}
+			if (*p == '#' || *p == '\n' || *p == '\r' || *p == 0){
+				continue;
+			}
+			status = parseCommand(p, &cmd);
+			if (status == SPA_OK && cmd.type == CMD_BOOK){
+				if (pending == BOOK_RUN){
+					runBookings(*head, bookings, bookLines, pending, report);
+					pending = 0;
+				}
+				bookings[pending].empNum = cmd.empNum;
+				bookings[pending].start = localToTime(cmd.days, cmd.minutes);
+				bookings[pending].length = cmd.length;
+				bookLines[pending++] = lineNum;
+				continue;
+			}
+		}
+		//anything else waits for the bookings before it
+		if (pending > 0){
+			runBookings(*head, bookings, bookLines, pending, report);
+			pending = 0;
+		}
+		if (status == SPA_OK){
+			status = runCommand(head, &cmd, NULL);
+		}
+		tallyLine(report, cmd.type, status, lineNum);
+	}
+	if (pending > 0){
+		runBookings(*head, bookings, bookLines, pending, report);
+	}
+	free(bookings);
+	free(bookLines);
+	report->seconds = batchClock() - start;
+	return ferror(fp) ? SPA_IO_ERROR : SPA_OK;
+}
+
+const char * statusName (int status){
+	switch (status){
+		case SPA_OK: return "ok";
+		case SPA_NOT_FOUND: return "not found";
+		case SPA_CONFLICT: return "conflict";
+		case SPA_INVALID: return "invalid";
+		case SPA_IO_ERROR: return "i/o error";
+	}
+	return "unknown";
+}
+
+void writeBatchReport (BatchReport * report, FILE * out){
+	int i, failed = report->unparsed;
+	fprintf(out, "\n-------------------------\nBATCH SUMMARY\n-------------------------\n");
+	for (i = 0; i < COMMAND_COUNT; i++){
+		if (report->ok[i] + report->failed[i] > 0){
+			fprintf(out, "%-10s %8d done %8d failed\n", commandNames[i], report->ok[i], report->failed[i]);
+		}
+		failed += report->failed[i];
+	}
+	if (report->unparsed > 0){
+		fprintf(out, "%-10s %8d unrecognised\n", "(unknown)", report->unparsed);
+	}
+	fprintf(out, "%d commands, %d failed, in %.3f s", report->lines, failed, report->seconds);
+	if (report->seconds > 0){
+		fprintf(out, " (%.0f commands/s)", report->lines / report->seconds);
+	}
+	fprintf(out, "\n");
+	for (i = 0; i < report->errorCount; i++){
+		fprintf(out, "NOTE: line %d: %s\n", report->errorLine[i], statusName(report->errorStatus[i]));
+	}
+	if (failed > report->errorCount){
+		fprintf(out, "NOTE: %d more failed lines not listed.\n", failed - report->errorCount);
+	}
+}
@@ -0,0 +1,93 @@
+/*
+
+Spa Employee System - batch commands
+
+One operation per line, fields separated by '|' as in appointments.txt. Blank lines and
+lines starting with '#' are skipped. Dates are mm/dd/yy, times HH:MM (24-hour), lengths in
+minutes and positions as written in employees.txt, in any case.
+
+	hire|Last|First|age|POSITION|hired
+	edit|empNum|Last|First|age|POSITION[|hired]
+	fire|empNum
+	fireall
+	book|empNum|date|time|minutes
+	reschedule|appId|date|time
+	reassign|appId|empNum
+	cancel|appId
+	save
+
+A rescheduled or reassigned appointment keeps its ID, so later lines can still refer to it.
+
+*/
+
+#ifndef SPA_BATCH_H
+#define SPA_BATCH_H
+
+#include <stdio.h>
+#include "spa_core.h"
+
+#define COMMAND_SIZE 256 //longest command line accepted, newline included
+#define BATCH_ERRORS 10 //failed lines listed by name in a batch report
+
+enum batch_command{
+	CMD_HIRE,
+	CMD_EDIT,
+	CMD_FIRE,
+	CMD_FIRE_ALL,
+	CMD_BOOK,
+	CMD_RESCHEDULE,
+	CMD_REASSIGN,
+	CMD_CANCEL,
+	CMD_SAVE,
+	COMMAND_COUNT,
+	CMD_NONE = -1 //line could not be parsed
+};
+
+//command keywords, indexed by enum batch_command
+extern const char * const commandNames[COMMAND_COUNT];
+
+//a parsed command line; only the fields its command uses are set
+typedef struct command{
+	int type; //enum batch_command
+	int empNum;
+	int appId;
+	int days; //date, as a day number
+	int minutes; //time of day
+	int length; //seconds
+	int hasHired; //edit gave a hiring date
+	char last[NAME_SIZE]; //names for hire and edit, interned when the command runs; the name store
+	char first[NAME_SIZE]; //is shared, so the server must not touch it before taking its store lock
+	Employee details; //age, position and hiring date for hire and edit, and the names once interned
+} Command;
+
+//outcome of one command
+typedef struct command_result{
+	int type; //enum batch_command, or CMD_NONE
+	int status; //SPA_ status code
+	int id; //employee hired or appointment booked; on SPA_CONFLICT the appointment in the way
+} CommandResult;
+
+//totals over a command file
+typedef struct batch_report{
+	int lines; //commands run, skipped lines not included
+	int ok[COMMAND_COUNT];
+	int failed[COMMAND_COUNT];
+	int unparsed;
+	int errorCount; //entries used in the two arrays below
+	int errorLine[BATCH_ERRORS];
+	int errorStatus[BATCH_ERRORS];
+	double seconds;
+} BatchReport;
+
+//field functions
+int splitFields (char * line, char ** fields, int max);
+int parseNumber (const char * text, int * value);
+
+//batch functions
+int parseCommand (char * line, Command * cmd);
+int runCommand (Employee ** head, Command * cmd, CommandResult * result);
+int runBatch (Employee ** head, FILE * fp, BatchReport * report);
+void writeBatchReport (BatchReport * report, FILE * out);
+const char * statusName (int status);
+
+#endif
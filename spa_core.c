@@ -0,0 +1,3449 @@
+/*
+
+Spa Employee System - core
+
+Data structures and file formats behind the menu program: the roster as a name-ordered
+AVL tree threaded with a linked list, hash indexes by employee number and appointment ID,
+per-position buckets, each employee's appointments in a balanced interval tree, the text
+files, the binary snapshot and the change journal. Nothing in this file reads the terminal
+or writes to stdout; see spa_core.h for the operations it exports.
+
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#endif
+#include "spa_core.h"
+#define LOAD_BLOCK (1 << 20) //bytes read per fread when loading appointments
+#define DAY_CACHE 4096 //local midnights remembered by the civil date functions, a power of two
+#define SNAP_FILE "spa.snap"
+#define SNAP_MAGIC "SPASNAP"
+#define SNAP_VERSION 1
+#define SLAB_NODES 4096 //nodes carved from each pool slab
+#define SAVE_BLOCK (1 << 20) //bytes formatted before each write when saving
+#define JOURNAL_FILE "spa.journal"
+#define LOAD_THREADS 16 //most threads the parallel loader starts
+#define PARALLEL_MIN (1 << 20) //appointment files smaller than this are parsed on one thread
+#define DAY_SLOTS (24 * 60 / SLOT_MINUTES)
+#define SLOT_WORDS ((DAY_SLOTS + 63) / 64)
+
+typedef struct day_entry{
+	int key; //day number
+	time_t midnight;
+	int regular; //exactly 24 hours with no DST change, so minutes can be added directly
+} DayEntry;
+
+//binary snapshot layout: header, empCount SnapEmp in roster order, then each employee's
+//SnapApp records in time order; native byte order, every record a multiple of 8 bytes
+typedef struct snap_header{
+	char magic[8];
+	uint32_t version;
+	uint32_t empCount;
+	uint32_t appCount;
+	uint32_t maxEmpId;
+	uint32_t maxAppId;
+	uint32_t reserved;
+	uint64_t checksum; //over everything after the header
+} SnapHeader;
+
+typedef struct snap_emp{
+	int32_t empNum;
+	int32_t age;
+	int32_t hiredYear; //tm_year
+	int32_t hiredMon; //tm_mon
+	int32_t hiredDay;
+	int32_t appCount;
+	char last[NAME_SIZE];
+	char first[NAME_SIZE];
+	char position[32];
+} SnapEmp;
+
+typedef struct snap_app{
+	int64_t start;
+	int32_t id;
+	int32_t length;
+} SnapApp;
+
+//one fixed-width journal record per add, edit or delete since the last compaction
+typedef struct journal_rec{
+	uint32_t op;
+	uint32_t checksum; //over everything after this field
+	int32_t appId; //appointment the operation refers to
+	int32_t reserved;
+	SnapEmp emp;
+	SnapApp app; //new state of the appointment
+} JournalRec;
+
+enum journal_op{
+	J_HIRE = 1,
+	J_EDIT_EMP,
+	J_FIRE,
+	J_FIRE_ALL,
+	J_BOOK,
+	J_MOVE,
+	J_CANCEL
+};
+
+//output buffer shared by the save functions; written to a temp file that replaces the real one
+typedef struct out_buf{
+	FILE * fp;
+	char * data;
+	size_t len;
+	int failed;
+	char tmpName[64];
+} OutBuf;
+
+//fixed-size node allocator: nodes are carved from large slabs and recycled through a free list
+typedef struct slab{
+	struct slab * next;
+	double align; //keeps the nodes after the header aligned
+} Slab;
+
+typedef struct pool{
+	const char * name;
+	size_t nodeSize;
+	Slab * slabs;
+	void * freeList;
+	char * cursor; //next uncarved node in the newest slab
+	char * slabEnd;
+	long allocs;
+	long frees;
+	long live;
+	long peak;
+	int slabCount;
+} Pool;
+
+//busy slots of one employee on one day; made the first time the free-slot search looks at the
+//day, then kept current as appointments are added, moved and cancelled
+typedef struct day_map{
+	int empNum;
+	int day;
+	uint64_t busy[SLOT_WORDS]; //bit s is set when an appointment overlaps slot s
+	struct day_map * hashNext;
+} DayMap;
+
+//the appointments starting on one day, across all employees
+typedef struct day_list{
+	int day;
+	int count;
+	int size;
+	Appointment ** apps; //in (start, id) order
+	struct day_list * hashNext;
+} DayList;
+
+//the requests of a booking batch for one employee, chained in request order
+typedef struct booking_group{
+	Employee * emp;
+	int first; //request indexes; the chain continues through the batch's next array
+	int last;
+	int hashNext; //next group in the same hash slot, -1 at the end
+} BookingGroup;
+
+//one appointments.txt section parsed by a loader thread; the employee is looked up afterwards
+typedef struct load_section{
+	int empNum;
+	Appointment * first; //in file order through next
+	Appointment * root; //built when the section is in time order without overlaps, else NULL
+	int count;
+	int ordered;
+} LoadSection;
+
+//a run of whole sections of appointments.txt and what a loader thread made of it
+typedef struct load_chunk{
+	char * begin;
+	char * end;
+	Pool pool; //the thread's own nodes, adopted by appPool afterwards
+	LoadSection * sections;
+	int sectionCount;
+	int sectionSize;
+	int legacy; //a section without an EMPLOYEE line, which only the serial loader can place
+	int skipped; //lines with a field missing or out of range
+#ifdef SPA_STATS
+	uint64_t stats[STAT_COUNTERS];
+#endif
+} LoadChunk;
+
+const char * const positionNames[POSITION_COUNT + 1] = {"AESTHETICIAN", "HAIR STYLIST", "MASSAGE THERAPIST", "NAIL TECHNICIAN", "SALON SERVICES ATTENDANT", "SPA ATTENDANT", "SPA MANAGEMENT", "SPA RECEPTIONIST", "UNASSIGNED"};
+
+//utilities functions
+time_t toStart (struct tm schedule);
+DayEntry * localDay (int days);
+void localTime (time_t t, struct tm * out);
+int compareNames(Employee * emp1, Employee * emp2);
+void generateId (Employee * emp);
+
+//thread functions
+void lockShared ();
+void unlockShared ();
+
+//allocator functions
+Employee * allocEmployee ();
+void freeEmployee (Employee * emp);
+Appointment * allocAppointment ();
+void freeAppointment (Appointment * app);
+void * poolAlloc (Pool * pool);
+void poolAdopt (Pool * pool, Pool * from);
+void poolReset (Pool * pool);
+
+//index functions
+void indexEmployee (Employee * emp);
+void unindexEmployee (Employee * emp);
+Employee * unlinkEmployee (Employee * head, Employee * emp);
+void indexPosition (Employee * emp);
+Employee * positionBefore (Employee * emp);
+void unindexPosition (Employee * emp);
+void rebuildPositionIndex (Employee * head);
+Employee * buildEmpTree (Employee ** cursor, int count);
+int compareEmpKeys (Employee * emp1, Employee * emp2);
+Employee * treeRemoveEmp (Employee * node, Employee * emp);
+void indexAppointment (Appointment * app);
+void unindexAppointment (Appointment * app);
+void unlinkAppointment (Appointment * app);
+Appointment * findOverlap (Appointment * root, time_t start, time_t end, Appointment * skip);
+void updateAppNode (Appointment * node);
+Appointment * lookupAppointment (int id);
+
+//slot map functions
+DayMap * findDayMap (Employee * emp, int day);
+void fillDayMap (DayMap * map, Employee * emp);
+void markDayMap (DayMap * map, Appointment * app);
+void updateDayMaps (Appointment * app, Employee * emp, int added);
+void dropDayMaps (int empNum);
+void freeStarts (const uint64_t * busy, int need, const uint64_t * window, uint64_t * starts);
+
+//calendar functions
+void buildCalendar ();
+void calendarAdd (Appointment * app);
+void calendarRemove (Appointment * app);
+void clearCalendar ();
+
+//save/load functions
+int scanDigits (char ** p, int * value);
+int scanField (char ** p, int * value, char sep);
+int parseAppLine (char * line, int * days, int * minuteOfDay, int * id, int * length);
+void copyField (char * dest, int size, char * line, int len, int keepNewline);
+int saveSnapshot (Employee * head);
+Employee * loadSnapshot (Employee * head, LoadReport * report);
+void journalEmployee (int op, Employee * emp);
+void journalAppointment (int op, int appId, Appointment * app);
+Employee * replayJournal (Employee * head, LoadReport * report);
+Appointment * buildAppTree (Appointment ** nodes, int lo, int hi);
+int loadParallel (Employee ** head, int threads);
+
+//roster functions
+Employee * addEmployee (Employee * head, Employee * emp);
+Employee * delAllEmps (Employee * head);
+void delEmpApps (Employee * emp);
+int insertAppointment (Employee * emp, Appointment * newApp);
+void attachAppointment (Employee * emp, Appointment * app);
+void mergeBookings (Employee * emp, Appointment * added, int count);
+void detachAppointment (Appointment * app);
+
+int maxGlobalID = 0;
+int maxAppID = 0;
+
+//hash index from empNum to Employee node, chained through hashNext
+Employee ** empIndex = NULL;
+int empIndexSize = 0;
+int empIndexCount = 0;
+
+//interned names: each distinct name is stored once, NUL-terminated, and employees keep its offset;
+//offset 0 is the empty string, so a zero slot in nameTable is free
+char * nameArena = NULL;
+uint32_t nameArenaSize = 0;
+uint32_t nameArenaUsed = 0;
+uint32_t * nameTable = NULL;
+uint32_t nameTableSize = 0;
+uint32_t nameCount = 0;
+
+//ordered name index over the roster
+Employee * empRoot = NULL;
+
+//per-position buckets over the roster
+Employee * posHead[POSITION_COUNT + 1];
+Employee * posTail[POSITION_COUNT + 1];
+
+//hash index from appointment id to Appointment node; the node knows its owner
+Appointment ** appIndex = NULL;
+int appIndexSize = 0;
+int appIndexCount = 0;
+
+//hash index from (empNum, day) to DayMap
+DayMap ** mapIndex = NULL;
+int mapIndexSize = 0;
+int mapIndexCount = 0;
+
+//hash index from day number to the day's appointments; made by the first day query, then kept
+//current by insertAppointment() and unlinkAppointment()
+DayList ** calendar = NULL;
+int calendarSize = 0;
+int calendarCount = 0;
+int calendarBuilt = EXITED;
+
+Pool empPool = {.name = "employee", .nodeSize = sizeof(Employee)};
+Pool appPool = {.name = "appointment", .nodeSize = sizeof(Appointment)};
+Pool mapPool = {.name = "day map", .nodeSize = sizeof(DayMap)};
+
+THREAD_LOCAL DayEntry * dayCache = NULL; //DAY_CACHE entries, allocated on first use in each thread
+
+char * saveBuffer = NULL; //SAVE_BLOCK bytes, allocated on the first save and reused
+
+//append-only journal of changes since the snapshot files were last written
+FILE * journal = NULL;
+int journalCount = 0;
+
+int loadThreads = 0;
+
+//taken around the appointment index, the appointment pool, the ID counter and the journal
+//while sharedStore is set; everything else is left to the caller's locks
+int sharedStore = EXITED;
+#ifndef _WIN32
+pthread_mutex_t sharedLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+int beginSave (OutBuf * out, const char * name){
+	if (saveBuffer == NULL){
+		saveBuffer = (char *) malloc(SAVE_BLOCK);
+	}
+	snprintf(out->tmpName, sizeof(out->tmpName), "%s.tmp", name);
+	out->fp = fopen(out->tmpName, "wb");
+	out->data = saveBuffer;
+	out->len = 0;
+	out->failed = (out->fp == NULL);
+	return !out->failed;
+}
+
+void flushOut (OutBuf * out){
+	if (out->len > 0 && fwrite(out->data, 1, out->len, out->fp) != out->len){
+		out->failed = 1;
+	}
+	STAT_ADD(STAT_BYTES, out->len);
+	out->len = 0;
+}
+
+//renames the finished temp file over the real one; a failed save leaves the old file alone
+int endSave (OutBuf * out, const char * name){
+	flushOut(out);
+	if (fclose(out->fp) != 0){
+		out->failed = 1;
+	}
+#ifdef _WIN32
+	if (!out->failed){
+		remove(name);
+	}
+#endif
+	if (out->failed || rename(out->tmpName, name) != 0){
+		remove(out->tmpName);
+		return SPA_IO_ERROR;
+	}
+	return SPA_OK;
+}
+
+char * reserveOut (OutBuf * out, size_t len){
+	if (out->len + len > SAVE_BLOCK){
+		flushOut(out);
+	}
+	char * p = out->data + out->len;
+	out->len += len;
+	return p;
+}
+
+void putText (OutBuf * out, const char * text, size_t len){
+	if (len > SAVE_BLOCK){
+		flushOut(out);
+		if (fwrite(text, 1, len, out->fp) != len){
+			out->failed = 1;
+		}
+		STAT_ADD(STAT_BYTES, len);
+		return;
+	}
+	memcpy(reserveOut(out, len), text, len);
+}
+
+void putInt (OutBuf * out, int value){
+	char digits[12];
+	int n = 0;
+	unsigned int v = (value < 0) ? 0u - (unsigned int) value : (unsigned int) value;
+	do{
+		digits[n++] = '0' + v % 10;
+		v /= 10;
+	} while (v != 0);
+	if (value < 0){
+		digits[n++] = '-';
+	}
+	char * p = reserveOut(out, n);
+	while (n > 0){
+		*p++ = digits[--n];
+	}
+}
+
+void put2 (char * p, int value){
+	p[0] = '0' + (value / 10) % 10;
+	p[1] = '0' + value % 10;
+}
+
+//days since 01/01/1970 in the proleptic Gregorian calendar, without going through mktime
+int daysFromCivil (int year, int month, int day){
+	year += (month - 1) / 12;
+	month = (month - 1) % 12 + 1;
+	if (month < 1){
+		month += 12;
+		year--;
+	}
+	year -= (month <= 2);
+	int era = (year >= 0 ? year : year - 399) / 400;
+	int yoe = year - era * 400;
+	int doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
+}
+
+void civilFromDays (int days, int * year, int * month, int * day){
+	days += 719468;
+	int era = (days >= 0 ? days : days - 146096) / 146097;
+	int doe = days - era * 146097;
+	int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	int mp = (5 * doy + 2) / 153;
+	*day = doy - (153 * mp + 2) / 5 + 1;
+	*month = (mp < 10) ? mp + 3 : mp - 9;
+	*year = yoe + era * 400 + (*month <= 2);
+}
+
+//two-digit years below 50 are 20yy, the rest 19yy
+int fullYear (int year){
+	if (year < 50){
+		return year + 2000;
+	} else if (year < 100){
+		return year + 1900;
+	}
+	return year;
+}
+
+int daysInMonth (int year, int month){
+	static const int lengths[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	if (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)){
+		return 29;
+	}
+	return lengths[month - 1];
+}
+
+int twoDigits (const char * p){
+	if (!isdigit((unsigned char) p[0]) || !isdigit((unsigned char) p[1])){
+		return -1;
+	}
+	return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+//accepts exactly mm/dd/yy naming a real date, which is what the C locale's %x prints
+int parseDate (const char * text, int * days){
+	if (strlen(text) != 8 || text[2] != '/' || text[5] != '/'){
+		return EXITED;
+	}
+	int month = twoDigits(text), day = twoDigits(text + 3), year = twoDigits(text + 6);
+	if (month < 1 || month > 12 || year < 0){
+		return EXITED;
+	}
+	year = fullYear(year);
+	if (day < 1 || day > daysInMonth(year, month)){
+		return EXITED;
+	}
+	*days = daysFromCivil(year, month, day);
+	return ACTIVE;
+}
+
+//accepts exactly HH:MM on the 24-hour clock and gives minutes after midnight
+int parseClock (const char * text, int * minutes){
+	if (strlen(text) != 5 || text[2] != ':'){
+		return EXITED;
+	}
+	int hour = twoDigits(text), minute = twoDigits(text + 3);
+	if (hour < 0 || hour > 23 || minute < 0 || minute > 59){
+		return EXITED;
+	}
+	*minutes = hour * 60 + minute;
+	return ACTIVE;
+}
+
+//mm/dd/yy and a terminator, 9 bytes
+void formatDate (char * out, int days){
+	int year, month, day;
+	civilFromDays(days, &year, &month, &day);
+	put2(out, month);
+	out[2] = '/';
+	put2(out + 3, day);
+	out[5] = '/';
+	put2(out + 6, year % 100);
+	out[8] = 0;
+}
+
+//mm/dd/yy at hh:mmAM, as strftime's "%x at %I:%M%p" prints it; 20 bytes
+void formatSchedule (char * out, time_t start){
+	int days, minutes;
+	timeToLocal(start, &days, &minutes);
+	int hour = minutes / 60;
+	formatDate(out, days);
+	memcpy(out + 8, " at ", 4);
+	put2(out + 12, (hour % 12 == 0) ? 12 : hour % 12);
+	out[14] = ':';
+	put2(out + 15, minutes % 60);
+	memcpy(out + 17, (hour < 12) ? "AM" : "PM", 3);
+}
+
+//true when t shows as the given day number and second of the day in local time
+int localIs (time_t t, int days, int seconds){
+	struct tm check;
+	localTime(t, &check);
+	return daysFromCivil(check.tm_year + 1900, check.tm_mon + 1, check.tm_mday) == days
+		&& check.tm_hour * 3600 + check.tm_min * 60 + check.tm_sec == seconds;
+}
+
+//local midnight of a day number; the time zone rules are only consulted the first time a day is seen
+DayEntry * localDay (int days){
+	if (dayCache == NULL){
+		dayCache = (DayEntry *) malloc(DAY_CACHE * sizeof(DayEntry));
+		memset(dayCache, 0xff, DAY_CACHE * sizeof(DayEntry));
+	}
+	DayEntry * entry = &dayCache[(unsigned int) days & (DAY_CACHE - 1)];
+	if (entry->key != days || entry->regular < 0){
+		struct tm schedule;
+		int year, month, day;
+		memset(&schedule, 0, sizeof(schedule));
+		civilFromDays(days, &year, &month, &day);
+		schedule.tm_year = year - 1900;
+		schedule.tm_mon = month - 1;
+		schedule.tm_mday = day;
+		entry->midnight = toStart(schedule);
+		
+		//a day that starts and ends on an unambiguous midnight 24 hours apart has no clock change in it
+		entry->regular = localIs(entry->midnight, days, 0) && localIs(entry->midnight - 1, days - 1, 86399)
+			&& localIs(entry->midnight + 86400, days + 1, 0);
+		entry->key = days;
+	}
+	return entry;
+}
+
+time_t localToTime (int days, int minutes){
+	DayEntry * entry = localDay(days);
+	if (entry->regular){
+		return entry->midnight + minutes * 60;
+	}
+	
+	//the clocks change today, so let mktime place the time
+	struct tm schedule;
+	int year, month, day;
+	memset(&schedule, 0, sizeof(schedule));
+	civilFromDays(days, &year, &month, &day);
+	schedule.tm_year = year - 1900;
+	schedule.tm_mon = month - 1;
+	schedule.tm_mday = day;
+	schedule.tm_hour = minutes / 60;
+	schedule.tm_min = minutes % 60;
+	return toStart(schedule);
+}
+
+void timeToLocal (time_t t, int * days, int * minutes){
+	static THREAD_LOCAL time_t offset = 0; //midnight minus day * 86400 for the last day found
+	time_t shifted = t - offset;
+	int day = (int) (shifted / 86400 - (shifted % 86400 < 0));
+	DayEntry * entry = localDay(day);
+	
+	//the guess is off by a day at most when the offset changed since the last call, except
+	//across zone changes such as a skipped date, hence the loops
+	while (t < entry->midnight){
+		entry = localDay(--day);
+	}
+	while (t - entry->midnight >= 86400 && localDay(day + 1)->midnight <= t){
+		entry = localDay(++day);
+	}
+	offset = entry->midnight - (time_t) day * 86400;
+	if (entry->regular && t - entry->midnight < 86400){
+		*days = day;
+		*minutes = (int) (t - entry->midnight) / 60;
+	} else{
+		struct tm schedule;
+		localTime(t, &schedule);
+		*days = daysFromCivil(schedule.tm_year + 1900, schedule.tm_mon + 1, schedule.tm_mday);
+		*minutes = schedule.tm_hour * 60 + schedule.tm_min;
+	}
+}
+
+void localTime (time_t t, struct tm * out){
+	STAT_ADD(STAT_LOCALTIME, 1);
+#ifdef _WIN32
+	localtime_s(out, &t);
+#else
+	localtime_r(&t, out);
+#endif
+}
+
+int saveEmployees (Employee * head){
+	Employee * temp = NULL;
+	OutBuf out;
+	temp = head;
+	if (!beginSave(&out, "employees.txt")){
+		return SPA_IO_ERROR;
+	}
+	while (temp!=NULL){
+		static const char banner[] = "-----------EMPLOYEE INFO-----------\n";
+		putText(&out, banner, sizeof(banner) - 1);
+		const char * last = empLast(temp), * first = empFirst(temp);
+		putText(&out, last, strlen(last));
+		putText(&out, "\n", 1);
+		putText(&out, first, strlen(first));
+		putText(&out, "\n", 1);
+		putInt(&out, temp->empNum);
+		putText(&out, "\n", 1);
+		putInt(&out, temp->age);
+		putText(&out, "\n", 1);
+		putText(&out, positionNames[temp->position], strlen(positionNames[temp->position]));
+		char * p = reserveOut(&out, 10);
+		p[0] = '\n';
+		formatDate(p + 1, empHired(temp));
+		p[9] = '\n';
+		temp = temp->next;
+	}
+	return endSave(&out, "employees.txt");
+}
+
+int saveAppointments (Employee * head){
+	Employee * temp = NULL;
+	OutBuf out;
+	temp = head;
+	if (!beginSave(&out, "appointments.txt")){
+		return SPA_IO_ERROR;
+	}
+	
+	//the day is converted once; other appointments that day take their time from its midnight
+	time_t dayStart = 0, dayEnd = 0;
+	char day[9];
+	while (temp!=NULL){
+		Appointment * appTemp = NULL;
+		appTemp = temp->app;
+		putText(&out, "EMPLOYEE|", 9);
+		putInt(&out, temp->empNum);
+		putText(&out, "\n", 1);
+		while(appTemp!=NULL){
+			time_t start = appTemp->start;
+			int hour, minute;
+			if (start >= dayStart && start < dayEnd){
+				hour = (start - dayStart) / 3600;
+				minute = (start - dayStart) / 60 % 60;
+			} else{
+				int days, minutes;
+				timeToLocal(start, &days, &minutes);
+				formatDate(day, days);
+				hour = minutes / 60;
+				minute = minutes % 60;
+				DayEntry * entry = localDay(days);
+				dayStart = entry->midnight;
+				dayEnd = entry->regular ? dayStart + 86400 : dayStart; //DST changes today, so don't reuse it
+			}
+			//mm/dd/yy|HH:MM|id|minutes
+			char * p = reserveOut(&out, 15);
+			memcpy(p, day, 8);
+			p[8] = '|';
+			put2(p + 9, hour);
+			p[11] = ':';
+			put2(p + 12, minute);
+			p[14] = '|';
+			putInt(&out, appTemp->id);
+			putText(&out, "|", 1);
+			putInt(&out, appTemp->length / 60);
+			putText(&out, "\n", 1);
+			appTemp = appTemp->next;
+		}	
+		putText(&out, "---END---\n", 10);
+		temp = temp->next;
+	}
+
+	return endSave(&out, "appointments.txt");
+}
+
+//Fletcher-style sum over 32-bit words; len is a multiple of 8
+uint64_t snapChecksum (const unsigned char * data, size_t len){
+	uint64_t a = 1, b = 0;
+	size_t i;
+	for (i = 0; i < len; i += 4){
+		uint32_t word;
+		memcpy(&word, data + i, 4);
+		a = (a + word) % 0xFFFFFFFBu;
+		b = (b + a) % 0xFFFFFFFBu;
+	}
+	return (b << 32) | a;
+}
+
+void packEmployee (SnapEmp * rec, Employee * emp){
+	memset(rec, 0, sizeof(SnapEmp));
+	rec->empNum = emp->empNum;
+	rec->age = emp->age;
+	int year, month, day;
+	civilFromDays(empHired(emp), &year, &month, &day);
+	rec->hiredYear = year - 1900;
+	rec->hiredMon = month - 1;
+	rec->hiredDay = day;
+	strncpy(rec->last, empLast(emp), sizeof(rec->last) - 1);
+	strncpy(rec->first, empFirst(emp), sizeof(rec->first) - 1);
+	strcpy(rec->position, positionNames[emp->position]);
+}
+
+//the record may be mapped read-only, so its fields are copied out before being terminated
+void unpackEmployee (Employee * emp, SnapEmp * rec){
+	char last[NAME_SIZE], first[NAME_SIZE], position[sizeof(rec->position)];
+	emp->empNum = rec->empNum;
+	emp->age = rec->age;
+	copyField(last, sizeof(last), rec->last, strnlen(rec->last, sizeof(rec->last)), 0);
+	copyField(first, sizeof(first), rec->first, strnlen(rec->first, sizeof(rec->first)), 0);
+	setEmpName(emp, last, first);
+	memcpy(position, rec->position, sizeof(position));
+	position[sizeof(position) - 1] = 0;
+	emp->position = findPosition(position);
+	setEmpHired(emp, daysFromCivil(rec->hiredYear + 1900, rec->hiredMon + 1, rec->hiredDay));
+}
+
+int saveSnapshot (Employee * head){
+	SnapHeader header;
+	Employee * temp;
+	size_t empCount = 0, appCount = 0;
+	for (temp = head; temp!=NULL; temp = temp->next){
+		Appointment * app;
+		empCount++;
+		for (app = temp->app; app!=NULL; app = app->next){
+			appCount++;
+		}
+	}
+	
+	size_t size = empCount * sizeof(SnapEmp) + appCount * sizeof(SnapApp);
+	unsigned char * body = (unsigned char *) calloc(1, size + 1);
+	SnapEmp * emps = (SnapEmp *) body;
+	SnapApp * apps = (SnapApp *) (body + empCount * sizeof(SnapEmp));
+	size_t e = 0, a = 0;
+	for (temp = head; temp!=NULL; temp = temp->next, e++){
+		Appointment * app;
+		packEmployee(&emps[e], temp);
+		for (app = temp->app; app!=NULL; app = app->next, a++){
+			apps[a].start = app->start;
+			apps[a].id = app->id;
+			apps[a].length = app->length;
+			emps[e].appCount++;
+		}
+	}
+	
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SNAP_MAGIC, sizeof(SNAP_MAGIC));
+	header.version = SNAP_VERSION;
+	header.empCount = empCount;
+	header.appCount = appCount;
+	header.maxEmpId = maxGlobalID;
+	header.maxAppId = maxAppID;
+	header.checksum = snapChecksum(body, size);
+	
+	OutBuf out;
+	int status = SPA_IO_ERROR;
+	if (beginSave(&out, SNAP_FILE)){
+		putText(&out, (char *) &header, sizeof(header));
+		putText(&out, (char *) body, size);
+		status = endSave(&out, SNAP_FILE);
+	}
+	free(body);
+	return status;
+}
+
+//balanced tree over nodes[lo..hi], which are already in time order
+Appointment * buildAppTree (Appointment ** nodes, int lo, int hi){
+	if (lo > hi){
+		return NULL;
+	}
+	int mid = lo + (hi - lo) / 2;
+	Appointment * node = nodes[mid];
+	node->left = buildAppTree(nodes, lo, mid - 1);
+	node->right = buildAppTree(nodes, mid + 1, hi);
+	updateAppNode(node);
+	return node;
+}
+
+//returns 1 if the snapshot is at least as new as the text files it was saved with
+int snapshotIsCurrent (){
+	struct stat snap, text;
+	if (stat(SNAP_FILE, &snap) != 0){
+		return 0;
+	}
+	if (stat("employees.txt", &text) == 0 && text.st_mtime > snap.st_mtime){
+		return 0;
+	}
+	if (stat("appointments.txt", &text) == 0 && text.st_mtime > snap.st_mtime){
+		return 0;
+	}
+	return 1;
+}
+
+//maps spa.snap and builds the roster straight from its fixed-width records
+Employee * loadSnapshot (Employee * head, LoadReport * report){
+	report->fromSnapshot = EXITED;
+	if (head!=NULL || !snapshotIsCurrent()){
+		return head;
+	}
+	
+	unsigned char * data = NULL;
+	size_t size = 0;
+#ifndef _WIN32
+	int fd = open(SNAP_FILE, O_RDONLY);
+	struct stat info;
+	if (fd < 0){
+		return head;
+	}
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t) sizeof(SnapHeader)){
+		close(fd);
+		return head;
+	}
+	size = info.st_size;
+	data = (unsigned char *) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED){
+		return head;
+	}
+#else
+	FILE * fp = fopen(SNAP_FILE, "rb");
+	if (fp == NULL){
+		return head;
+	}
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	rewind(fp);
+	data = (unsigned char *) malloc(size + 1);
+	size = fread(data, 1, size, fp);
+	fclose(fp);
+#endif
+	
+	SnapHeader * header = (SnapHeader *) data;
+	size_t body = size - sizeof(SnapHeader);
+	int valid = size >= sizeof(SnapHeader)
+		&& memcmp(header->magic, SNAP_MAGIC, sizeof(SNAP_MAGIC)) == 0
+		&& header->version == SNAP_VERSION
+		&& body == (size_t) header->empCount * sizeof(SnapEmp) + (size_t) header->appCount * sizeof(SnapApp)
+		&& header->checksum == snapChecksum(data + sizeof(SnapHeader), body);
+	
+	if (valid){
+		SnapEmp * emps = (SnapEmp *) (data + sizeof(SnapHeader));
+		uint32_t e, a = 0;
+		for (e = 0; e < header->empCount; e++){
+			if (emps[e].appCount < 0 || emps[e].appCount > (int32_t) (header->appCount - a)){
+				valid = 0;
+				break;
+			}
+			a += emps[e].appCount;
+		}
+		if (a != header->appCount){
+			valid = 0;
+		}
+	}
+	
+	if (valid){
+		SnapEmp * emps = (SnapEmp *) (data + sizeof(SnapHeader));
+		SnapApp * apps = (SnapApp *) (emps + header->empCount);
+		Appointment ** nodes = NULL;
+		int nodesSize = 0;
+		Employee * tail = NULL;
+		uint32_t e;
+		
+		for (e = 0; e < header->empCount; e++){
+			Employee * newEmp = allocEmployee();
+			unpackEmployee(newEmp, &emps[e]);
+			newEmp->hashNext = NULL;
+			newEmp->next = NULL;
+			newEmp->prev = tail;
+			if (tail!=NULL){
+				tail->next = newEmp;
+			} else{
+				head = newEmp;
+			}
+			tail = newEmp;
+			indexEmployee(newEmp);
+			
+			//the records are already in order, so the tree is built bottom-up without conflict checks
+			int count = emps[e].appCount, i;
+			if (count > nodesSize){
+				nodesSize = count;
+				nodes = (Appointment **) realloc(nodes, nodesSize * sizeof(Appointment *));
+			}
+			for (i = 0; i < count; i++, apps++){
+				Appointment * app = allocAppointment();
+				app->id = apps->id;
+				app->start = (time_t) apps->start;
+				app->length = apps->length;
+				app->owner = newEmp;
+				app->hashNext = NULL;
+				app->prev = (i > 0) ? nodes[i-1] : NULL;
+				app->next = NULL;
+				if (i > 0){
+					nodes[i-1]->next = app;
+				}
+				nodes[i] = app;
+				indexAppointment(app);
+			}
+			newEmp->app = (count > 0) ? nodes[0] : NULL;
+			newEmp->appRoot = buildAppTree(nodes, 0, count - 1);
+		}
+		free(nodes);
+		Employee * cursor = head;
+		empRoot = buildEmpTree(&cursor, header->empCount);
+		rebuildPositionIndex(head);
+		maxGlobalID = header->maxEmpId;
+		maxAppID = header->maxAppId;
+		report->fromSnapshot = ACTIVE;
+	} else{
+		report->snapshotRejected = ACTIVE;
+	}
+	
+#ifndef _WIN32
+	munmap(data, size);
+#else
+	free(data);
+#endif
+	return head;
+}
+
+//one fwrite and one flush per operation, so a crash loses at most the record being written
+void journalWrite (JournalRec * rec){
+	if (journal == NULL){ //closed while loading and replaying
+		return;
+	}
+	rec->checksum = (uint32_t) snapChecksum((unsigned char *) rec + 8, sizeof(JournalRec) - 8);
+	lockShared();
+	fwrite(rec, sizeof(JournalRec), 1, journal);
+	fflush(journal);
+	journalCount++;
+	unlockShared();
+	STAT_ADD(STAT_BYTES, sizeof(JournalRec));
+}
+
+void journalEmployee (int op, Employee * emp){
+	JournalRec rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.op = op;
+	if (emp!=NULL){
+		packEmployee(&rec.emp, emp);
+	}
+	journalWrite(&rec);
+}
+
+void journalAppointment (int op, int appId, Appointment * app){
+	JournalRec rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.op = op;
+	rec.appId = appId;
+	if (app!=NULL){
+		rec.emp.empNum = (app->owner!=NULL) ? app->owner->empNum : 0;
+		rec.app.start = app->start;
+		rec.app.id = app->id;
+		rec.app.length = app->length;
+	}
+	journalWrite(&rec);
+}
+
+//applies one record; every operation is idempotent so a journal replayed on top of
+//snapshot files that already contain it leaves the data unchanged
+Employee * applyJournalRec (Employee * head, JournalRec * rec){
+	Employee * emp = findEmp(head, rec->emp.empNum);
+	Appointment * app = findAppointment(rec->appId);
+	switch (rec->op){
+		case J_HIRE:
+			if (emp == NULL){
+				emp = allocEmployee();
+				unpackEmployee(emp, &rec->emp);
+				emp->app = NULL;
+				emp->appRoot = NULL;
+				emp->hashNext = NULL;
+				head = addEmployee(head, emp);
+				if (emp->empNum > maxGlobalID){
+					maxGlobalID = emp->empNum;
+				}
+			}
+			break;
+		case J_EDIT_EMP:
+			if (emp!=NULL){
+				head = unlinkEmployee(head, emp);
+				unpackEmployee(emp, &rec->emp);
+				head = addEmployee(head, emp);
+			}
+			break;
+		case J_FIRE:
+			if (emp!=NULL){
+				head = unlinkEmployee(head, emp);
+				delEmpApps(emp);
+				freeEmployee(emp);
+			}
+			break;
+		case J_FIRE_ALL:
+			head = delAllEmps(head);
+			break;
+		case J_BOOK:
+			if (emp!=NULL && findAppointment(rec->app.id) == NULL){
+				app = allocAppointment();
+				app->id = rec->app.id;
+				app->start = (time_t) rec->app.start;
+				app->length = rec->app.length;
+				app->hashNext = NULL;
+				if (insertAppointment(emp, app) != 0){
+					freeAppointment(app);
+				}
+			}
+			if (rec->app.id > maxAppID){
+				maxAppID = rec->app.id;
+			}
+			break;
+		case J_MOVE:
+			if (emp!=NULL && app!=NULL){
+				rescheduleAppointment(app, emp, (time_t) rec->app.start, rec->app.id, NULL);
+			}
+			if (rec->app.id > maxAppID){
+				maxAppID = rec->app.id;
+			}
+			break;
+		case J_CANCEL:
+			if (app!=NULL){
+				unlinkAppointment(app);
+				freeAppointment(app);
+			}
+			break;
+	}
+	return head;
+}
+
+//replays spa.journal on top of the loaded files, then opens it for appending
+Employee * replayJournal (Employee * head, LoadReport * report){
+	FILE * fp = fopen(JOURNAL_FILE, "rb");
+	int replayed = 0, torn = 0;
+	if (fp!=NULL){
+		JournalRec rec;
+		while (fread(&rec, sizeof(rec), 1, fp) == 1){
+			if (rec.checksum != (uint32_t) snapChecksum((unsigned char *) &rec + 8, sizeof(rec) - 8)){
+				torn = 1; //a record cut short by a crash; nothing after it can be trusted
+				break;
+			}
+			head = applyJournalRec(head, &rec);
+			replayed++;
+		}
+		fclose(fp);
+	}
+	
+	report->recovered = replayed;
+	
+	//fold the replayed changes into the snapshot files and start a fresh journal; if that
+	//fails the journal is kept and appended to
+	if ((replayed == 0 && !torn) || saveStore(head) != SPA_OK){
+		journal = fopen(JOURNAL_FILE, "ab");
+	}
+	return head;
+}
+
+//snapshot if it is current, otherwise the text files; then whatever the journal adds
+int loadStore (Employee ** head, LoadReport * report){
+	memset(report, 0, sizeof(LoadReport));
+	*head = loadSnapshot(*head, report);
+	if (report->fromSnapshot == EXITED){ //no usable snapshot, or the text files were edited after it
+		report->skipped = loadTextFiles(head);
+	}
+	*head = replayJournal(*head, report);
+	return SPA_OK;
+}
+
+//writes the full state to the text files and the snapshot, then empties the journal; the
+//journal is only emptied once the text files are safely written
+int saveStore (Employee * head){
+	int status = saveEmployees(head);
+	if (status == SPA_OK){
+		status = saveAppointments(head);
+	}
+	if (status != SPA_OK){
+		return status;
+	}
+	saveSnapshot(head); //a failed snapshot is older than the text files, so it is ignored on the next load
+	if (journal!=NULL){
+		fclose(journal);
+	}
+	journal = fopen(JOURNAL_FILE, "wb");
+	journalCount = 0;
+	return SPA_OK;
+}
+
+void closeStore (){
+	if (journal!=NULL){
+		fclose(journal);
+		journal = NULL;
+	}
+}
+
+void lockShared (){
+#ifndef _WIN32
+	if (sharedStore){
+		pthread_mutex_lock(&sharedLock);
+	}
+#endif
+}
+
+void unlockShared (){
+#ifndef _WIN32
+	if (sharedStore){
+		pthread_mutex_unlock(&sharedLock);
+	}
+#endif
+}
+
+//frees what the calling thread cached for itself; for threads that used the core and are about to end
+void endThread (){
+	free(dayCache);
+	dayCache = NULL;
+}
+
+//parses a decimal number and steps over the separator that follows it
+int scanNumber (char ** p){
+	int value = 0;
+	while (**p >= '0' && **p <= '9'){
+		value = value * 10 + (**p - '0');
+		(*p)++;
+	}
+	if (**p == '/' || **p == ':' || **p == '|'){
+		(*p)++;
+	}
+	return value;
+}
+
+//a decimal field of at most nine digits; returns the number of digits read
+int scanDigits (char ** p, int * value){
+	int digits = 0;
+	*value = 0;
+	while (**p >= '0' && **p <= '9' && digits < 9){
+		*value = *value * 10 + (**p - '0');
+		(*p)++;
+		digits++;
+	}
+	return digits;
+}
+
+//a decimal field followed by sep, which is stepped over
+int scanField (char ** p, int * value, char sep){
+	if (scanDigits(p, value) == 0 || **p != sep){
+		return EXITED;
+	}
+	(*p)++;
+	return ACTIVE;
+}
+
+//one appointment line, mm/dd/yy|HH:MM|id|minutes up to its newline, with the minutes missing in
+//older files (length is then 0); EXITED when a field is missing or out of range
+int parseAppLine (char * line, int * days, int * minuteOfDay, int * id, int * length){
+	int month, day, year, hour, minute;
+	*length = 0;
+	if (!scanField(&line, &month, '/') || !scanField(&line, &day, '/') || !scanField(&line, &year, '|')
+		|| !scanField(&line, &hour, ':') || !scanField(&line, &minute, '|') || scanDigits(&line, id) == 0){
+		return EXITED;
+	}
+	if (*line == '|'){
+		line++;
+		if (scanDigits(&line, length) == 0){
+			return EXITED;
+		}
+	}
+	if (*line == '\r'){
+		line++;
+	}
+	if (*line != '\n'){
+		return EXITED;
+	}
+	year = fullYear(year);
+	if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month) || hour > 23 || minute > 59
+		|| *id <= 0 || *length > MAX_APP_MINUTES){
+		return EXITED;
+	}
+	*days = daysFromCivil(year, month, day);
+	*minuteOfDay = hour * 60 + minute;
+	return ACTIVE;
+}
+
+//streams appointments.txt in large blocks and parses each line in place
+//returns the number of lines that could not be loaded
+int loadAppointments(Employee * head){
+	FILE * fl = fopen("appointments.txt", "rb");
+	if (fl == NULL){
+		return 0;
+	}
+	
+	char * buffer = (char *) malloc(LOAD_BLOCK + 1);
+	size_t kept = 0;
+	int eof = 0, inSection = 0, skipped = 0;
+	Employee * emp = NULL;
+	Employee * nextEmp = head; //sections without an EMPLOYEE line follow roster order
+	
+	while (!eof){
+		size_t got = fread(buffer + kept, 1, LOAD_BLOCK - kept, fl);
+		size_t used = kept + got;
+		if (got == 0){
+			eof = 1;
+			if (used == 0){
+				break;
+			}
+			if (buffer[used-1] != '\n'){
+				buffer[used++] = '\n';
+			}
+		}
+		
+		char * p = buffer, * end = buffer + used;
+		char * nl;
+		while (p < end && (nl = (char *) memchr(p, '\n', end - p)) != NULL){
+			char * line = p;
+			p = nl + 1;
+			
+			if (strncmp(line, "---END---", 9) == 0){
+				if (!inSection && nextEmp!=NULL){ //empty section in the old format
+					nextEmp = nextEmp->next;
+				}
+				inSection = 0;
+				emp = NULL;
+				continue;
+			}
+			if (!inSection){
+				inSection = 1;
+				if (strncmp(line, "EMPLOYEE|", 9) == 0){
+					char * num = line + 9;
+					emp = findEmp(head, scanNumber(&num));
+					continue;
+				}
+				emp = nextEmp;
+				if (nextEmp!=NULL){
+					nextEmp = nextEmp->next;
+				}
+			}
+			if (emp == NULL){
+				skipped++;
+				continue;
+			}
+			
+			int days, minuteOfDay, id, minutes;
+			if (!parseAppLine(line, &days, &minuteOfDay, &id, &minutes)){
+				skipped++;
+				continue;
+			}
+			if (minutes == 0){
+				minutes = APP_LENGTH / 60; //files written before lengths were stored
+			}
+			
+			time_t start = localToTime(days, minuteOfDay);
+			
+			Appointment * app = allocAppointment();
+			app->id = id;
+			app->start = start;
+			app->length = minutes * 60;
+			app->hashNext = NULL;
+			if (insertAppointment(emp, app) != 0){
+				freeAppointment(app);
+				skipped++;
+				continue;
+			}
+			if (id > maxAppID){
+				maxAppID = id;
+			}
+		}
+		
+		kept = end - p;
+		if (kept == LOAD_BLOCK){ //a single line longer than the block is garbage
+			kept = 0;
+		}
+		memmove(buffer, p, kept);
+	}
+	
+	free(buffer);
+	fclose(fl);
+	return skipped;
+}
+
+//loads employees.txt and appointments.txt, in parallel when the appointments are worth it;
+//returns the number of appointments that could not be loaded
+int loadTextFiles (Employee ** head){
+	int threads = loadThreads;
+#ifndef _WIN32
+	if (threads <= 0){
+		threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (threads > LOAD_THREADS){
+		threads = LOAD_THREADS;
+	}
+	struct stat info;
+	if (threads > 1 && stat("appointments.txt", &info) == 0 && (info.st_size >= PARALLEL_MIN || loadThreads > 0)){
+		int skipped = loadParallel(head, threads);
+		if (skipped >= 0){
+			return skipped;
+		}
+	}
+#endif
+	*head = loadEmployees(*head);
+	return loadAppointments(*head);
+}
+
+#ifndef _WIN32
+//parses one chunk of appointments.txt the way loadAppointments() does, into the chunk's own
+//pool; sections in time order also get their tree, so only the linking is left for later
+void * loadChunk (void * arg){
+	LoadChunk * chunk = (LoadChunk *) arg;
+	char * p = chunk->begin, * nl;
+	LoadSection * section = NULL;
+	Appointment * last = NULL;
+	
+	while (p < chunk->end && (nl = (char *) memchr(p, '\n', chunk->end - p)) != NULL){
+		char * line = p;
+		p = nl + 1;
+		if (strncmp(line, "---END---", 9) == 0){
+			if (section == NULL){ //empty section in the old format
+				chunk->legacy = ACTIVE;
+				break;
+			}
+			section = NULL;
+			continue;
+		}
+		if (section == NULL){
+			if (strncmp(line, "EMPLOYEE|", 9) != 0){
+				chunk->legacy = ACTIVE;
+				break;
+			}
+			if (chunk->sectionCount == chunk->sectionSize){
+				chunk->sectionSize = (chunk->sectionSize == 0) ? 256 : chunk->sectionSize * 2;
+				chunk->sections = (LoadSection *) realloc(chunk->sections, chunk->sectionSize * sizeof(LoadSection));
+			}
+			section = &chunk->sections[chunk->sectionCount++];
+			char * num = line + 9;
+			section->empNum = scanNumber(&num);
+			section->first = NULL;
+			section->root = NULL;
+			section->count = 0;
+			section->ordered = ACTIVE;
+			last = NULL;
+			continue;
+		}
+		
+		int days, minuteOfDay, id, minutes;
+		if (!parseAppLine(line, &days, &minuteOfDay, &id, &minutes)){
+			chunk->skipped++;
+			continue;
+		}
+		if (minutes == 0){
+			minutes = APP_LENGTH / 60;
+		}
+		Appointment * app = (Appointment *) poolAlloc(&chunk->pool);
+		app->id = id;
+		app->start = localToTime(days, minuteOfDay);
+		app->length = minutes * 60;
+		app->hashNext = NULL;
+		app->next = NULL;
+		app->prev = last;
+		if (last!=NULL){
+			last->next = app;
+			if (app->start < last->start + last->length){
+				section->ordered = EXITED;
+			}
+		} else{
+			section->first = app;
+		}
+		last = app;
+		section->count++;
+	}
+	
+	Appointment ** nodes = NULL;
+	int nodesSize = 0, i;
+	for (i = 0; i < chunk->sectionCount && !chunk->legacy; i++){
+		section = &chunk->sections[i];
+		if (section->ordered && section->count > 0){
+			Appointment * app;
+			int n = 0;
+			if (section->count > nodesSize){
+				nodesSize = section->count;
+				nodes = (Appointment **) realloc(nodes, nodesSize * sizeof(Appointment *));
+			}
+			for (app = section->first; app!=NULL; app = app->next){
+				nodes[n++] = app;
+			}
+			section->root = buildAppTree(nodes, 0, section->count - 1);
+		}
+	}
+	free(nodes);
+	endThread();
+#ifdef SPA_STATS
+	memcpy(chunk->stats, statCounters, sizeof(chunk->stats));
+#endif
+	return NULL;
+}
+
+//reads appointments.txt in chunks of whole sections on worker threads while this thread loads
+//employees.txt, then links each section to its employee in file order; returns the number of
+//appointments skipped, or -1 (with nothing loaded) when the file needs the serial loader
+int loadParallel (Employee ** head, int threads){
+	FILE * fl = fopen("appointments.txt", "rb");
+	if (fl == NULL){
+		return -1;
+	}
+	fseek(fl, 0, SEEK_END);
+	long size = ftell(fl);
+	rewind(fl);
+	char * buffer = (char *) malloc(size + 2);
+	size = fread(buffer, 1, size, fl);
+	fclose(fl);
+	if (size > 0 && buffer[size-1] != '\n'){
+		buffer[size++] = '\n';
+	}
+	buffer[size] = 0;
+	
+	//chunk boundaries go just after the first ---END--- line past each even split
+	LoadChunk chunks[LOAD_THREADS];
+	pthread_t workers[LOAD_THREADS];
+	char * end = buffer + size, * begin = buffer;
+	int t, started = 0;
+	memset(chunks, 0, sizeof(chunks));
+	for (t = 0; t < threads; t++){
+		char * p = (t == threads - 1) ? end : buffer + size / threads * (t + 1);
+		if (p < begin){
+			p = begin;
+		}
+		while (p < end){
+			char * nl = (char *) memchr(p, '\n', end - p);
+			if (nl == NULL){
+				p = end;
+			} else if (strncmp(p, "---END---", 9) == 0 && (p == buffer || p[-1] == '\n')){
+				p = nl + 1;
+				break;
+			} else{
+				p = nl + 1;
+			}
+		}
+		chunks[t].begin = begin;
+		chunks[t].end = p;
+		chunks[t].pool.name = appPool.name;
+		chunks[t].pool.nodeSize = appPool.nodeSize;
+		begin = p;
+	}
+	tzset(); //read the time zone rules once here rather than first in several mktime calls at once
+	for (t = 0; t < threads; t++){
+		if (pthread_create(&workers[t], NULL, loadChunk, &chunks[t]) != 0){
+			break;
+		}
+		started++;
+	}
+	if (started < threads){
+		loadChunk(&chunks[started]); //no thread to spare; the rest are parsed here in turn
+		for (t = started + 1; t < threads; t++){
+			loadChunk(&chunks[t]);
+		}
+	}
+	
+	*head = loadEmployees(*head);
+	int legacy = 0;
+	for (t = 0; t < threads; t++){
+		if (t < started){
+			pthread_join(workers[t], NULL);
+		}
+		legacy |= chunks[t].legacy;
+	}
+	free(buffer);
+	
+	int skipped = 0;
+	for (t = 0; t < threads; t++){
+		LoadChunk * chunk = &chunks[t];
+		int i;
+		if (legacy){
+			poolReset(&chunk->pool);
+			free(chunk->sections);
+			continue;
+		}
+#ifdef SPA_STATS
+		if (t < started){
+			int k;
+			for (k = 0; k < STAT_COUNTERS; k++){
+				statCounters[k] += chunk->stats[k];
+			}
+		}
+		STAT_ADD(STAT_ALLOCS, chunk->pool.allocs);
+#endif
+		poolAdopt(&appPool, &chunk->pool);
+		skipped += chunk->skipped;
+		for (i = 0; i < chunk->sectionCount; i++){
+			LoadSection * section = &chunk->sections[i];
+			Employee * emp = findEmp(*head, section->empNum);
+			Appointment * app = section->first, * next;
+			if (emp!=NULL && emp->app == NULL && section->root!=NULL){
+				emp->app = app;
+				emp->appRoot = section->root;
+				for (; app!=NULL; app = app->next){
+					app->owner = emp;
+					indexAppointment(app);
+					if (app->id > maxAppID){
+						maxAppID = app->id;
+					}
+				}
+				continue;
+			}
+			//out of order, overlapping or joining earlier appointments: one at a time, as loadAppointments() would
+			for (; app!=NULL; app = next){
+				next = app->next;
+				app->next = NULL;
+				app->prev = NULL;
+				if (emp == NULL || insertAppointment(emp, app) != 0){
+					freeAppointment(app);
+					skipped++;
+				} else if (app->id > maxAppID){
+					maxAppID = app->id;
+				}
+			}
+		}
+		free(chunk->sections);
+	}
+	if (legacy){
+		return loadAppointments(*head);
+	}
+	return skipped;
+}
+#endif
+
+//returns the next line of the buffer and its length including the newline, or NULL at the end
+char * nextLine (char ** cursor, char * end, int * len){
+	char * line = *cursor;
+	if (line >= end){
+		return NULL;
+	}
+	char * nl = (char *) memchr(line, '\n', end - line);
+	char * stop = (nl!=NULL) ? nl + 1 : end;
+	*len = stop - line;
+	*cursor = stop;
+	return line;
+}
+
+//copies a line into a fixed field, truncating if needed; names keep their newline like enterName() does
+void copyField (char * dest, int size, char * line, int len, int keepNewline){
+	while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r')){
+		len--;
+	}
+	if (len > size - 1 - keepNewline){
+		len = size - 1 - keepNewline;
+	}
+	memcpy(dest, line, len);
+	if (keepNewline){
+		dest[len++] = '\n';
+	}
+	dest[len] = 0;
+}
+
+int compareEmpPtrs (const void * a, const void * b){
+	Employee * emp1 = *(Employee **) a;
+	Employee * emp2 = *(Employee **) b;
+	int cmp = compareNames(emp1, emp2);
+	if (cmp != 0){
+		return cmp;
+	}
+	return emp1->empNum - emp2->empNum;
+}
+
+//merges a sorted array of new employees into the sorted list in one pass, indexing each one
+Employee * mergeEmployees (Employee * head, Employee ** emps, int count){
+	Employee * temp = head, * tail = NULL;
+	int i = 0;
+	head = NULL;
+	while (temp!=NULL || i < count){
+		Employee * emp;
+		if (temp!=NULL && (i == count || compareEmpKeys(temp, emps[i]) <= 0)){
+			emp = temp;
+			temp = temp->next;
+		} else{
+			emp = emps[i++];
+			indexEmployee(emp);
+		}
+		emp->prev = tail;
+		if (tail!=NULL){
+			tail->next = emp;
+		} else{
+			head = emp;
+		}
+		tail = emp;
+	}
+	if (tail!=NULL){
+		tail->next = NULL;
+	}
+	Employee * cursor = head;
+	empRoot = buildEmpTree(&cursor, empIndexCount);
+	rebuildPositionIndex(head);
+	return head;
+}
+
+Employee * loadEmployees (Employee * head){
+	int maxId = maxGlobalID;
+	FILE * fp = fopen("employees.txt", "rb");
+	if (fp == NULL){
+		return head;
+	}
+	
+	//read the whole file once and parse it in place
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	rewind(fp);
+	char * buffer = (char *) malloc(size + 1);
+	size = fread(buffer, 1, size, fp);
+	buffer[size] = 0;
+	fclose(fp);
+	
+	int count = 0, capacity = 1024;
+	Employee ** emps = (Employee **) malloc(capacity * sizeof(Employee *));
+	char * cursor = buffer, * end = buffer + size;
+	int len;
+	while (nextLine(&cursor, end, &len) != NULL){ //-----------EMPLOYEE INFO-----------
+		char * fields[6];
+		int lens[6];
+		int i;
+		for (i = 0; i < 6; i++){
+			fields[i] = nextLine(&cursor, end, &lens[i]);
+			if (fields[i] == NULL){
+				break;
+			}
+		}
+		if (i < 6){ //truncated record
+			break;
+		}
+		
+		Employee * newEmp = allocEmployee();
+		char last[NAME_SIZE], first[NAME_SIZE];
+		copyField(last, sizeof(last), fields[0], lens[0], 0);
+		copyField(first, sizeof(first), fields[1], lens[1], 0);
+		setEmpName(newEmp, last, first);
+		newEmp->empNum = atoi(fields[2]);
+		newEmp->age = atoi(fields[3]);
+		char position[32];
+		copyField(position, sizeof(position), fields[4], lens[4], 0);
+		newEmp->position = findPosition(position);
+		
+		char * p = fields[5];
+		int month = (int) strtol(p, &p, 10);
+		int day = (*p == '/') ? (int) strtol(p + 1, &p, 10) : 1;
+		int year = (*p == '/') ? (int) strtol(p + 1, &p, 10) : 0;
+		setEmpHired(newEmp, daysFromCivil(fullYear(year), month, day));
+		newEmp->app = NULL;
+		newEmp->appRoot = NULL;
+		newEmp->next = NULL;
+		newEmp->prev = NULL;
+		newEmp->hashNext = NULL;
+		if (newEmp->empNum > maxId){
+			maxId = newEmp->empNum;
+		}
+		
+		if (count == capacity){
+			capacity *= 2;
+			emps = (Employee **) realloc(emps, capacity * sizeof(Employee *));
+		}
+		emps[count++] = newEmp;
+	}
+	free(buffer);
+	
+	//one sort instead of a sorted insert per record
+	qsort(emps, count, sizeof(Employee *), compareEmpPtrs);
+	head = mergeEmployees(head, emps, count);
+	free(emps);
+	
+	//new IDs continue after the highest loaded one so the index never sees duplicates
+	maxGlobalID = maxId;
+	return head;
+}
+
+void generateId (Employee * emp){
+	int EmpNum = maxGlobalID; 
+	EmpNum++;
+	emp->empNum = EmpNum;
+	maxGlobalID++;
+}
+
+//equal interned names share an offset, so most ties are settled without a strcmp
+int compareNames(Employee * emp1, Employee * emp2){
+	
+	if (emp1->last != emp2->last){
+		return strcmp(empLast(emp1), empLast(emp2));
+	} else if (emp1->first != emp2->first){
+		return strcmp(empFirst(emp1), empFirst(emp2));
+	}
+	return 0;
+
+}
+
+void * poolAlloc (Pool * pool){
+	void * node;
+	if (pool->freeList!=NULL){
+		node = pool->freeList;
+		pool->freeList = *(void **) node;
+	} else{
+		if (pool->cursor == pool->slabEnd){
+			Slab * slab = (Slab *) malloc(sizeof(Slab) + SLAB_NODES * pool->nodeSize);
+			if (slab == NULL){
+				fprintf(stderr, "NOTE: out of memory.\n");
+				exit(1);
+			}
+			slab->next = pool->slabs;
+			pool->slabs = slab;
+			pool->cursor = (char *) (slab + 1);
+			pool->slabEnd = pool->cursor + SLAB_NODES * pool->nodeSize;
+			pool->slabCount++;
+		}
+		node = pool->cursor;
+		pool->cursor += pool->nodeSize;
+	}
+	pool->allocs++;
+	pool->live++;
+	if (pool->live > pool->peak){
+		pool->peak = pool->live;
+	}
+	return node;
+}
+
+void poolFree (Pool * pool, void * node){
+	*(void **) node = pool->freeList;
+	pool->freeList = node;
+	pool->frees++;
+	pool->live--;
+}
+
+//releases every node at once by handing back the slabs
+void poolReset (Pool * pool){
+	while (pool->slabs!=NULL){
+		Slab * next = pool->slabs->next;
+		free(pool->slabs);
+		pool->slabs = next;
+	}
+	pool->freeList = NULL;
+	pool->cursor = NULL;
+	pool->slabEnd = NULL;
+	pool->frees += pool->live;
+	pool->live = 0;
+	pool->slabCount = 0;
+}
+
+//takes over the slabs of a pool filled elsewhere, such as by a loader thread; its uncarved
+//nodes join the free list
+void poolAdopt (Pool * pool, Pool * from){
+	while (from->cursor != from->slabEnd){
+		*(void **) from->cursor = from->freeList;
+		from->freeList = from->cursor;
+		from->cursor += from->nodeSize;
+	}
+	if (from->slabs!=NULL){
+		Slab * last = from->slabs;
+		while (last->next!=NULL){
+			last = last->next;
+		}
+		last->next = pool->slabs;
+		pool->slabs = from->slabs;
+	}
+	while (from->freeList!=NULL){
+		void * node = from->freeList;
+		from->freeList = *(void **) node;
+		*(void **) node = pool->freeList;
+		pool->freeList = node;
+	}
+	pool->allocs += from->allocs;
+	pool->frees += from->frees;
+	pool->live += from->live;
+	if (pool->live > pool->peak){
+		pool->peak = pool->live;
+	}
+	pool->slabCount += from->slabCount;
+	from->slabs = NULL;
+	from->cursor = NULL;
+	from->slabEnd = NULL;
+	from->allocs = from->frees = from->live = from->peak = 0;
+	from->slabCount = 0;
+}
+
+uint32_t hashName (const char * name){
+	//FNV-1a
+	uint32_t hash = 2166136261u;
+	while (*name){
+		hash = (hash ^ (unsigned char) *name++) * 16777619u;
+	}
+	return hash;
+}
+
+void growNameTable (){
+	uint32_t newSize = (nameTableSize == 0) ? 1024 : nameTableSize * 2;
+	uint32_t * newTable = (uint32_t *) calloc(newSize, sizeof(uint32_t));
+	uint32_t i;
+	if (newTable == NULL){
+		fprintf(stderr, "NOTE: out of memory.\n");
+		exit(1);
+	}
+	for (i = 0; i < nameTableSize; i++){
+		if (nameTable[i] != 0){
+			uint32_t slot = hashName(nameArena + nameTable[i]) & (newSize - 1);
+			while (newTable[slot] != 0){
+				slot = (slot + 1) & (newSize - 1);
+			}
+			newTable[slot] = nameTable[i];
+		}
+	}
+	free(nameTable);
+	nameTable = newTable;
+	nameTableSize = newSize;
+}
+
+//offset of the one stored copy of name, adding it to the arena the first time it is seen
+uint32_t internName (const char * name){
+	if (nameArena == NULL){
+		nameArenaSize = 4096;
+		nameArena = (char *) malloc(nameArenaSize);
+		if (nameArena == NULL){
+			fprintf(stderr, "NOTE: out of memory.\n");
+			exit(1);
+		}
+		nameArena[0] = 0;
+		nameArenaUsed = 1;
+	}
+	if (name[0] == 0){
+		return 0;
+	}
+	if ((nameCount + 1) * 2 > nameTableSize){
+		growNameTable();
+	}
+	uint32_t slot = hashName(name) & (nameTableSize - 1);
+	while (nameTable[slot] != 0){
+		if (strcmp(nameArena + nameTable[slot], name) == 0){
+			return nameTable[slot];
+		}
+		slot = (slot + 1) & (nameTableSize - 1);
+	}
+	
+	uint32_t len = strlen(name) + 1;
+	if (nameArenaUsed + len > nameArenaSize){
+		while (nameArenaUsed + len > nameArenaSize){
+			nameArenaSize *= 2;
+		}
+		nameArena = (char *) realloc(nameArena, nameArenaSize);
+		if (nameArena == NULL){
+			fprintf(stderr, "NOTE: out of memory.\n");
+			exit(1);
+		}
+	}
+	memcpy(nameArena + nameArenaUsed, name, len);
+	nameTable[slot] = nameArenaUsed;
+	nameArenaUsed += len;
+	nameCount++;
+	return nameTable[slot];
+}
+
+//forgets every name once no employee refers to them
+void resetNames (){
+	if (nameTableSize > 0){
+		memset(nameTable, 0, nameTableSize * sizeof(uint32_t));
+	}
+	nameArenaUsed = (nameArena!=NULL) ? 1 : 0;
+	nameCount = 0;
+}
+
+const char * empLast (Employee * emp){
+	return nameArena + emp->last;
+}
+
+const char * empFirst (Employee * emp){
+	return nameArena + emp->first;
+}
+
+void setEmpName (Employee * emp, const char * last, const char * first){
+	emp->last = internName(last);
+	emp->first = internName(first);
+}
+
+//day number, see daysFromCivil()
+int empHired (Employee * emp){
+	return emp->hired;
+}
+
+void setEmpHired (Employee * emp, int days){
+	emp->hired = days;
+}
+
+Employee * allocEmployee (){
+	STAT_ADD(STAT_ALLOCS, 1);
+	return (Employee *) poolAlloc(&empPool);
+}
+
+void freeEmployee (Employee * emp){
+	poolFree(&empPool, emp);
+}
+
+Appointment * allocAppointment (){
+	STAT_ADD(STAT_ALLOCS, 1);
+	lockShared();
+	Appointment * app = (Appointment *) poolAlloc(&appPool);
+	unlockShared();
+	return app;
+}
+
+void freeAppointment (Appointment * app){
+	lockShared();
+	poolFree(&appPool, app);
+	unlockShared();
+}
+
+//allocation counts at exit; live nodes the roster can't reach are leaks
+void reportPools (Employee * head, FILE * out){
+	long emps = 0, apps = 0;
+	Employee * temp;
+	for (temp = head; temp!=NULL; temp = temp->next){
+		Appointment * app;
+		emps++;
+		for (app = temp->app; app!=NULL; app = app->next){
+			apps++;
+		}
+	}
+	Pool * pools[3] = {&empPool, &appPool, &mapPool};
+	long reachable[3] = {emps, apps, mapIndexCount};
+	int i;
+	for (i = 0; i < 3; i++){
+		fprintf(out, "%s nodes: %ld allocated, %ld freed, %ld live (peak %ld) in %d slabs\n", pools[i]->name, pools[i]->allocs, pools[i]->frees, pools[i]->live, pools[i]->peak, pools[i]->slabCount);
+		if (pools[i]->live != reachable[i]){
+			fprintf(out, "NOTE: %ld %s nodes leaked\n", pools[i]->live - reachable[i], pools[i]->name);
+		}
+	}
+	if (emps > 0){
+		fprintf(out, "employee records: %d bytes each, plus %u distinct names in %u bytes (%.1f bytes per employee)\n", (int) sizeof(Employee), nameCount, nameArenaUsed, sizeof(Employee) + (double) (nameArenaUsed + nameTableSize * sizeof(uint32_t)) / emps);
+	}
+}
+
+unsigned int hashId (int id, int size){
+	//Fibonacci hashing; size is always a power of two
+	return ((unsigned int) id * 2654435761u) & (unsigned int) (size - 1);
+}
+
+void growEmpIndex (){
+	int newSize = (empIndexSize == 0) ? 64 : empIndexSize * 2;
+	Employee ** newIndex = (Employee **) calloc (newSize, sizeof(Employee *));
+	int i;
+	for (i = 0; i < empIndexSize; i++){
+		Employee * emp = empIndex[i];
+		while (emp!=NULL){
+			Employee * next = emp->hashNext;
+			unsigned int slot = hashId(emp->empNum, newSize);
+			emp->hashNext = newIndex[slot];
+			newIndex[slot] = emp;
+			emp = next;
+		}
+	}
+	free (empIndex);
+	empIndex = newIndex;
+	empIndexSize = newSize;
+}
+
+void indexEmployee (Employee * emp){
+	if (empIndexCount >= empIndexSize){
+		growEmpIndex();
+	}
+	unsigned int slot = hashId(emp->empNum, empIndexSize);
+	emp->hashNext = empIndex[slot];
+	empIndex[slot] = emp;
+	empIndexCount++;
+}
+
+void unindexEmployee (Employee * emp){
+	if (empIndexSize == 0){
+		return;
+	}
+	Employee ** link = &empIndex[hashId(emp->empNum, empIndexSize)];
+	while (*link!=NULL && *link!=emp){
+		link = &(*link)->hashNext;
+	}
+	if (*link!=NULL){
+		*link = emp->hashNext;
+		emp->hashNext = NULL;
+		empIndexCount--;
+	}
+}
+
+void delEmpApps (Employee * emp){
+	Appointment * app = emp->app;
+	while (app!=NULL){
+		Appointment * next = app->next;
+		calendarRemove(app);
+		unindexAppointment(app);
+		freeAppointment(app);
+		app = next;
+	}
+	emp->app = NULL;
+	emp->appRoot = NULL;
+	dropDayMaps(emp->empNum);
+}
+
+int findPosition (const char * name){
+	int i;
+	for (i = 0; i < POSITION_COUNT; i++){
+		if (strcmp(name, positionNames[i]) == 0){
+			return i;
+		}
+	}
+	return POS_NONE;
+}
+
+//links emp into its position bucket right after 'after', or at the front when after is NULL
+void bucketInsertAfter (Employee * emp, Employee * after){
+	int pos = emp->position;
+	emp->posPrev = after;
+	emp->posNext = (after!=NULL) ? after->posNext : posHead[pos];
+	if (emp->posNext!=NULL){
+		emp->posNext->posPrev = emp;
+	} else{
+		posTail[pos] = emp;
+	}
+	if (after!=NULL){
+		after->posNext = emp;
+	} else{
+		posHead[pos] = emp;
+	}
+}
+
+//the nearest earlier employee in the roster with the same position is the bucket predecessor;
+//the position masks of the name tree lead to it in O(log n), however rare the position
+void indexPosition (Employee * emp){
+	bucketInsertAfter(emp, positionBefore(emp));
+}
+
+//last employee before emp in name order with emp's position, or NULL; emp must be in the tree
+Employee * positionBefore (Employee * emp){
+	uint16_t bit = (uint16_t) (1u << emp->position);
+	Employee * node = empRoot, * found = NULL, * subtree = NULL;
+	
+	//each time the search goes right, the node and its left subtree come before emp and after
+	//every candidate seen so far
+	while (node!=NULL){
+		STAT_ADD(STAT_NODES, 1);
+		if (node == emp){
+			node = node->left;
+			if (node!=NULL && (node->positions & bit)){
+				found = NULL;
+				subtree = node;
+			}
+			break;
+		}
+		if (compareEmpKeys(node, emp) < 0){
+			if (node->position == emp->position){
+				found = node;
+				subtree = NULL;
+			} else if (node->left!=NULL && (node->left->positions & bit)){
+				found = NULL;
+				subtree = node->left;
+			}
+			node = node->right;
+		} else{
+			node = node->left;
+		}
+	}
+	
+	//the rightmost match in the subtree
+	while (subtree!=NULL){
+		STAT_ADD(STAT_NODES, 1);
+		if (subtree->right!=NULL && (subtree->right->positions & bit)){
+			subtree = subtree->right;
+		} else if (subtree->position == emp->position){
+			return subtree;
+		} else{
+			subtree = subtree->left;
+		}
+	}
+	return found;
+}
+
+void unindexPosition (Employee * emp){
+	int pos = emp->position;
+	if (emp->posPrev!=NULL){
+		emp->posPrev->posNext = emp->posNext;
+	} else{
+		posHead[pos] = emp->posNext;
+	}
+	if (emp->posNext!=NULL){
+		emp->posNext->posPrev = emp->posPrev;
+	} else{
+		posTail[pos] = emp->posPrev;
+	}
+	emp->posNext = NULL;
+	emp->posPrev = NULL;
+}
+
+//refiles the whole roster in one pass; used after bulk loads
+void rebuildPositionIndex (Employee * head){
+	memset(posHead, 0, sizeof(posHead));
+	memset(posTail, 0, sizeof(posTail));
+	while (head!=NULL){
+		bucketInsertAfter(head, posTail[head->position]);
+		head = head->next;
+	}
+}
+
+Employee * unlinkEmployee (Employee * head, Employee * emp){
+	unindexEmployee(emp);
+	unindexPosition(emp);
+	empRoot = treeRemoveEmp(empRoot, emp);
+	if (emp->prev!=NULL){
+		emp->prev->next = emp->next;
+	} else{
+		head = emp->next;
+	}
+	if (emp->next!=NULL){
+		emp->next->prev = emp->prev;
+	}
+	emp->next = NULL;
+	emp->prev = NULL;
+	return head;
+}
+
+int empHeight (Employee * node){
+	return (node == NULL) ? 0 : node->height;
+}
+
+void updateEmpNode (Employee * node){
+	int lh = empHeight(node->left), rh = empHeight(node->right);
+	node->height = 1 + (lh > rh ? lh : rh);
+	node->positions = (uint16_t) (1u << node->position);
+	if (node->left!=NULL){
+		node->positions |= node->left->positions;
+	}
+	if (node->right!=NULL){
+		node->positions |= node->right->positions;
+	}
+}
+
+Employee * rotateEmpRight (Employee * node){
+	Employee * pivot = node->left;
+	node->left = pivot->right;
+	pivot->right = node;
+	updateEmpNode(node);
+	updateEmpNode(pivot);
+	return pivot;
+}
+
+Employee * rotateEmpLeft (Employee * node){
+	Employee * pivot = node->right;
+	node->right = pivot->left;
+	pivot->left = node;
+	updateEmpNode(node);
+	updateEmpNode(pivot);
+	return pivot;
+}
+
+Employee * balanceEmps (Employee * node){
+	updateEmpNode(node);
+	int balance = empHeight(node->left) - empHeight(node->right);
+	if (balance > 1){
+		if (empHeight(node->left->left) < empHeight(node->left->right)){
+			node->left = rotateEmpLeft(node->left);
+		}
+		return rotateEmpRight(node);
+	} else if (balance < -1){
+		if (empHeight(node->right->right) < empHeight(node->right->left)){
+			node->right = rotateEmpRight(node->right);
+		}
+		return rotateEmpLeft(node);
+	}
+	return node;
+}
+
+//name order with the employee number as tie-break, so every node has one place in the tree
+int compareEmpKeys (Employee * emp1, Employee * emp2){
+	int cmp = compareNames(emp1, emp2);
+	if (cmp != 0){
+		return cmp;
+	}
+	return emp1->empNum - emp2->empNum;
+}
+
+Employee * treeInsertEmp (Employee * node, Employee * newEmp, Employee ** prev, Employee ** next){
+	if (node == NULL){
+		newEmp->left = NULL;
+		newEmp->right = NULL;
+		updateEmpNode(newEmp);
+		return newEmp;
+	}
+	STAT_ADD(STAT_NODES, 1);
+	if (compareEmpKeys(newEmp, node) < 0){
+		*next = node;
+		node->left = treeInsertEmp(node->left, newEmp, prev, next);
+	} else{
+		*prev = node;
+		node->right = treeInsertEmp(node->right, newEmp, prev, next);
+	}
+	return balanceEmps(node);
+}
+
+Employee * treeRemoveMinEmp (Employee * node, Employee ** min){
+	if (node->left == NULL){
+		*min = node;
+		return node->right;
+	}
+	node->left = treeRemoveMinEmp(node->left, min);
+	return balanceEmps(node);
+}
+
+Employee * treeRemoveEmp (Employee * node, Employee * emp){
+	if (node == NULL){
+		return NULL;
+	}
+	STAT_ADD(STAT_NODES, 1);
+	if (node == emp){
+		if (node->left == NULL){
+			return node->right;
+		} else if (node->right == NULL){
+			return node->left;
+		} else{
+			Employee * min = NULL;
+			Employee * right = treeRemoveMinEmp(node->right, &min);
+			min->left = node->left;
+			min->right = right;
+			return balanceEmps(min);
+		}
+	}
+	if (compareEmpKeys(emp, node) < 0){
+		node->left = treeRemoveEmp(node->left, emp);
+	} else{
+		node->right = treeRemoveEmp(node->right, emp);
+	}
+	return balanceEmps(node);
+}
+
+//balanced tree over the next count employees of an ordered list; *cursor ends up past them
+Employee * buildEmpTree (Employee ** cursor, int count){
+	if (count <= 0){
+		return NULL;
+	}
+	Employee * left = buildEmpTree(cursor, count / 2);
+	Employee * node = *cursor;
+	*cursor = node->next;
+	node->left = left;
+	node->right = buildEmpTree(cursor, count - count / 2 - 1);
+	updateEmpNode(node);
+	return node;
+}
+
+//first employee in name order whose surname starts with prefix, or NULL
+Employee * findBySurname (const char * prefix){
+	Employee * node = empRoot, * found = NULL;
+	while (node!=NULL){
+		STAT_ADD(STAT_NODES, 1);
+		if (strcmp(empLast(node), prefix) >= 0){
+			found = node;
+			node = node->left;
+		} else{
+			node = node->right;
+		}
+	}
+	if (found!=NULL && strncmp(empLast(found), prefix, strlen(prefix)) != 0){
+		found = NULL;
+	}
+	return found;
+}
+
+//links an employee into the roster and its indexes
+Employee * addEmployee(Employee * head, Employee * newEmp){
+	//the tree finds the neighbours in O(log n); the list is threaded between them
+	Employee * prev = NULL, * next = NULL;
+	empRoot = treeInsertEmp(empRoot, newEmp, &prev, &next);
+	newEmp->prev = prev;
+	newEmp->next = next;
+	if (prev!=NULL){
+		prev->next = newEmp;
+	} else{
+		head = newEmp;
+	}
+	if (next!=NULL){
+		next->prev = newEmp;
+	}
+	indexEmployee(newEmp);
+	indexPosition(newEmp);
+
+	return head;
+}
+
+//the record fields (names, age, position, date hired) are copied from details into a new employee
+int hireEmployee (Employee ** head, Employee * details, Employee ** hired){
+	if (details->position >= POSITION_COUNT){
+		return SPA_INVALID;
+	}
+	Employee * newEmp = allocEmployee();
+	newEmp->last = details->last;
+	newEmp->first = details->first;
+	newEmp->age = details->age;
+	newEmp->position = details->position;
+	newEmp->hired = details->hired;
+	newEmp->app = NULL;
+	newEmp->appRoot = NULL;
+	newEmp->hashNext = NULL;
+	generateId(newEmp);
+	*head = addEmployee(*head, newEmp);
+	journalEmployee(J_HIRE, newEmp);
+	if (hired!=NULL){
+		*hired = newEmp;
+	}
+	return SPA_OK;
+}
+
+//replaces an employee's record fields with those of details; a new name or position moves it
+int changeEmployee (Employee ** head, int empNum, Employee * details){
+	Employee * emp = findEmp(*head, empNum);
+	if (emp == NULL){
+		return SPA_NOT_FOUND;
+	}
+	if (details->position >= POSITION_COUNT){
+		return SPA_INVALID;
+	}
+	*head = unlinkEmployee(*head, emp);
+	emp->last = details->last;
+	emp->first = details->first;
+	emp->age = details->age;
+	emp->position = details->position;
+	emp->hired = details->hired;
+	*head = addEmployee(*head, emp);
+	journalEmployee(J_EDIT_EMP, emp);
+	return SPA_OK;
+}
+
+int fireEmployee (Employee ** head, int empNum){
+	Employee * emp = findEmp(*head, empNum);
+	if (emp == NULL){
+		return SPA_NOT_FOUND;
+	}
+	journalEmployee(J_FIRE, emp);
+	*head = unlinkEmployee(*head, emp);
+	delEmpApps(emp);
+	freeEmployee(emp);
+	return SPA_OK;
+}
+
+int fireAllEmployees (Employee ** head){
+	journalEmployee(J_FIRE_ALL, NULL);
+	*head = delAllEmps(*head);
+	return SPA_OK;
+}
+
+//every employee and appointment goes at once, so the indexes are cleared and both pools reset
+Employee * delAllEmps (Employee * head){
+	(void) head; //the pools hold every record, so the list is not walked
+	if (empIndexSize > 0){
+		memset(empIndex, 0, empIndexSize * sizeof(Employee *));
+	}
+	if (appIndexSize > 0){
+		memset(appIndex, 0, appIndexSize * sizeof(Appointment *));
+	}
+	if (mapIndexSize > 0){
+		memset(mapIndex, 0, mapIndexSize * sizeof(DayMap *));
+	}
+	empIndexCount = 0;
+	appIndexCount = 0;
+	mapIndexCount = 0;
+	memset(posHead, 0, sizeof(posHead));
+	memset(posTail, 0, sizeof(posTail));
+	empRoot = NULL;
+	resetNames();
+	poolReset(&empPool);
+	poolReset(&appPool);
+	poolReset(&mapPool);
+	clearCalendar();
+	return NULL;
+}
+
+Employee * findEmp (Employee * head, int empNum){
+	Employee * emp = NULL;
+	(void) head; //found through the index
+	if (empIndexSize == 0){
+		return NULL;
+	}
+	emp = empIndex[hashId(empNum, empIndexSize)];
+
+	while (emp!=NULL && emp->empNum!=empNum){
+		STAT_ADD(STAT_NODES, 1);
+		emp = emp->hashNext;
+	}
+	
+	return emp;
+	
+}
+
+//the owner is read under the same lock as the index, since another thread may be moving the appointment
+Employee * findBookedEmp (Employee * head, int appId){
+	Employee * owner = NULL;
+	(void) head; //found through the index
+	lockShared();
+	Appointment * app = lookupAppointment(appId);
+	if (app!=NULL){
+		owner = app->owner;
+	}
+	unlockShared();
+	return owner;
+}
+
+int generateAppId(){
+		lockShared();
+		int id = ++maxAppID;
+		unlockShared();
+		return id;
+		
+}
+
+time_t toStart (struct tm schedule){
+	schedule.tm_sec = 0;
+	schedule.tm_isdst = -1;
+	STAT_ADD(STAT_MKTIME, 1);
+	return mktime(&schedule);
+}
+
+void growAppIndex (){
+	int newSize = (appIndexSize == 0) ? 64 : appIndexSize * 2;
+	Appointment ** newIndex = (Appointment **) calloc (newSize, sizeof(Appointment *));
+	int i;
+	for (i = 0; i < appIndexSize; i++){
+		Appointment * app = appIndex[i];
+		while (app!=NULL){
+			Appointment * next = app->hashNext;
+			unsigned int slot = hashId(app->id, newSize);
+			app->hashNext = newIndex[slot];
+			newIndex[slot] = app;
+			app = next;
+		}
+	}
+	free (appIndex);
+	appIndex = newIndex;
+	appIndexSize = newSize;
+}
+
+void indexAppointment (Appointment * app){
+	lockShared();
+	if (appIndexCount >= appIndexSize){
+		growAppIndex();
+	}
+	unsigned int slot = hashId(app->id, appIndexSize);
+	app->hashNext = appIndex[slot];
+	appIndex[slot] = app;
+	appIndexCount++;
+	unlockShared();
+}
+
+void unindexAppointment (Appointment * app){
+	lockShared();
+	if (appIndexSize == 0){
+		unlockShared();
+		return;
+	}
+	Appointment ** link = &appIndex[hashId(app->id, appIndexSize)];
+	while (*link!=NULL && *link!=app){
+		link = &(*link)->hashNext;
+	}
+	if (*link!=NULL){
+		*link = app->hashNext;
+		app->hashNext = NULL;
+		appIndexCount--;
+	}
+	unlockShared();
+}
+
+int appHeight (Appointment * node){
+	return (node == NULL) ? 0 : node->height;
+}
+
+void updateAppNode (Appointment * node){
+	int lh = appHeight(node->left), rh = appHeight(node->right);
+	node->height = 1 + (lh > rh ? lh : rh);
+	node->maxEnd = node->start + node->length;
+	if (node->left!=NULL && node->left->maxEnd > node->maxEnd){
+		node->maxEnd = node->left->maxEnd;
+	}
+	if (node->right!=NULL && node->right->maxEnd > node->maxEnd){
+		node->maxEnd = node->right->maxEnd;
+	}
+}
+
+Appointment * rotateAppRight (Appointment * node){
+	Appointment * pivot = node->left;
+	node->left = pivot->right;
+	pivot->right = node;
+	updateAppNode(node);
+	updateAppNode(pivot);
+	return pivot;
+}
+
+Appointment * rotateAppLeft (Appointment * node){
+	Appointment * pivot = node->right;
+	node->right = pivot->left;
+	pivot->left = node;
+	updateAppNode(node);
+	updateAppNode(pivot);
+	return pivot;
+}
+
+Appointment * balanceApps (Appointment * node){
+	updateAppNode(node);
+	int balance = appHeight(node->left) - appHeight(node->right);
+	if (balance > 1){
+		if (appHeight(node->left->left) < appHeight(node->left->right)){
+			node->left = rotateAppLeft(node->left);
+		}
+		return rotateAppRight(node);
+	} else if (balance < -1){
+		if (appHeight(node->right->right) < appHeight(node->right->left)){
+			node->right = rotateAppRight(node->right);
+		}
+		return rotateAppLeft(node);
+	}
+	return node;
+}
+
+int compareApps (Appointment * app1, Appointment * app2){
+	if (app1->start != app2->start){
+		return (app1->start < app2->start) ? -1 : 1;
+	}
+	return app1->id - app2->id;
+}
+
+//tree insert; remembers the nearest neighbours on the way down so the node can be threaded
+Appointment * treeInsertApp (Appointment * node, Appointment * newApp, Appointment ** prev, Appointment ** next){
+	if (node == NULL){
+		newApp->left = NULL;
+		newApp->right = NULL;
+		updateAppNode(newApp);
+		return newApp;
+	}
+	STAT_ADD(STAT_NODES, 1);
+	if (compareApps(newApp, node) < 0){
+		*next = node;
+		node->left = treeInsertApp(node->left, newApp, prev, next);
+	} else{
+		*prev = node;
+		node->right = treeInsertApp(node->right, newApp, prev, next);
+	}
+	return balanceApps(node);
+}
+
+Appointment * treeRemoveMinApp (Appointment * node, Appointment ** min){
+	if (node->left == NULL){
+		*min = node;
+		return node->right;
+	}
+	node->left = treeRemoveMinApp(node->left, min);
+	return balanceApps(node);
+}
+
+//tree delete that relinks nodes instead of copying them, so index pointers stay valid
+Appointment * treeRemoveApp (Appointment * node, Appointment * app){
+	if (node == NULL){
+		return NULL;
+	}
+	STAT_ADD(STAT_NODES, 1);
+	if (node == app){
+		if (node->left == NULL){
+			return node->right;
+		} else if (node->right == NULL){
+			return node->left;
+		} else{
+			Appointment * min = NULL;
+			Appointment * right = treeRemoveMinApp(node->right, &min);
+			min->left = node->left;
+			min->right = right;
+			return balanceApps(min);
+		}
+	}
+	if (compareApps(app, node) < 0){
+		node->left = treeRemoveApp(node->left, app);
+	} else{
+		node->right = treeRemoveApp(node->right, app);
+	}
+	return balanceApps(node);
+}
+
+//earliest appointment in the tree overlapping [start, end), ignoring skip
+Appointment * findOverlap (Appointment * root, time_t start, time_t end, Appointment * skip){
+	if (root == NULL || root->maxEnd <= start){
+		return NULL;
+	}
+	STAT_ADD(STAT_NODES, 1);
+	Appointment * found = findOverlap(root->left, start, end, skip);
+	if (found!=NULL){
+		return found;
+	}
+	if (root->start >= end){
+		return NULL;
+	}
+	if (root!=skip && root->start + root->length > start){
+		return root;
+	}
+	return findOverlap(root->right, start, end, skip);
+}
+
+//links newApp into the employee's schedule; returns 0 or the ID of the conflicting appointment
+int insertAppointment(Employee * emp, Appointment * newApp){
+	Appointment * conflict = findOverlap(emp->appRoot, newApp->start, newApp->start + newApp->length, NULL);
+	if (conflict!=NULL){
+		return conflict->id;
+	}
+	attachAppointment(emp, newApp);
+	indexAppointment(newApp);
+	return 0;
+}
+
+//threads app into emp's tree and list at its start time, with no conflict check; the ID index is left alone
+void attachAppointment (Employee * emp, Appointment * app){
+	Appointment * prev = NULL, * next = NULL;
+	emp->appRoot = treeInsertApp(emp->appRoot, app, &prev, &next);
+	app->prev = prev;
+	app->next = next;
+	if (prev!=NULL){
+		prev->next = app;
+	} else{
+		emp->app = app;
+	}
+	if (next!=NULL){
+		next->prev = app;
+	}
+	lockShared(); //read with the index by findBookedEmp()
+	app->owner = emp;
+	unlockShared();
+	calendarAdd(app);
+	updateDayMaps(app, emp, ACTIVE);
+}
+
+//takes app out of its owner's tree and list; the owner field and the ID index are left alone
+void detachAppointment (Appointment * app){
+	Employee * emp = app->owner;
+	calendarRemove(app);
+	emp->appRoot = treeRemoveApp(emp->appRoot, app);
+	if (app->prev!=NULL){
+		app->prev->next = app->next;
+	} else{
+		emp->app = app->next;
+	}
+	if (app->next!=NULL){
+		app->next->prev = app->prev;
+	}
+	app->next = NULL;
+	app->prev = NULL;
+	app->left = NULL;
+	app->right = NULL;
+	updateDayMaps(app, emp, EXITED);
+}
+
+void unlinkAppointment (Appointment * app){
+	unindexAppointment(app);
+	if (app->owner!=NULL){
+		detachAppointment(app);
+	}
+	app->owner = NULL;
+}
+
+Appointment * findAppointment (int id){
+	lockShared();
+	Appointment * app = lookupAppointment(id);
+	unlockShared();
+	return app;
+}
+
+Appointment * lookupAppointment (int id){
+	Appointment * app = NULL;
+	if (appIndexSize == 0){
+		return NULL;
+	}
+	app = appIndex[hashId(id, appIndexSize)];
+	while (app!=NULL && app->id!=id){
+		STAT_ADD(STAT_NODES, 1);
+		app = app->hashNext;
+	}
+	
+	return app;
+	
+}
+
+//SPA_OK when emp is free from start for length seconds, else SPA_CONFLICT and the appointment in the way
+int checkAvailability (Employee * emp, time_t start, int length, int * conflictId){
+	if (emp == NULL){
+		return SPA_NOT_FOUND;
+	}
+	if (length <= 0 || length > MAX_APP_MINUTES * 60){
+		return SPA_INVALID;
+	}
+	Appointment * conflict = findOverlap(emp->appRoot, start, start + length, NULL);
+	if (conflict!=NULL){
+		if (conflictId!=NULL){
+			*conflictId = conflict->id;
+		}
+		return SPA_CONFLICT;
+	}
+	return SPA_OK;
+}
+
+DayMap * lookupDayMap (int empNum, int day){
+	DayMap * map;
+	if (mapIndexSize == 0){
+		return NULL;
+	}
+	map = mapIndex[hashId(empNum * 40503 + day, mapIndexSize)];
+	while (map!=NULL && (map->empNum!=empNum || map->day!=day)){
+		STAT_ADD(STAT_NODES, 1);
+		map = map->hashNext;
+	}
+	return map;
+}
+
+void growMapIndex (){
+	int newSize = (mapIndexSize == 0) ? 1024 : mapIndexSize * 2;
+	DayMap ** newIndex = (DayMap **) calloc (newSize, sizeof(DayMap *));
+	int i;
+	for (i = 0; i < mapIndexSize; i++){
+		DayMap * map = mapIndex[i];
+		while (map!=NULL){
+			DayMap * next = map->hashNext;
+			unsigned int slot = hashId(map->empNum * 40503 + map->day, newSize);
+			map->hashNext = newIndex[slot];
+			newIndex[slot] = map;
+			map = next;
+		}
+	}
+	free (mapIndex);
+	mapIndex = newIndex;
+	mapIndexSize = newSize;
+}
+
+//the employee's map of the day, made from the appointment tree the first time it is asked for
+DayMap * findDayMap (Employee * emp, int day){
+	DayMap * map = lookupDayMap(emp->empNum, day);
+	if (map == NULL){
+		if (mapIndexCount >= mapIndexSize){
+			growMapIndex();
+		}
+		map = (DayMap *) poolAlloc(&mapPool);
+		map->empNum = emp->empNum;
+		map->day = day;
+		fillDayMap(map, emp);
+		unsigned int slot = hashId(emp->empNum * 40503 + day, mapIndexSize);
+		map->hashNext = mapIndex[slot];
+		mapIndex[slot] = map;
+		mapIndexCount++;
+	}
+	return map;
+}
+
+//marks the appointments overlapping the map's day, found with one tree search and then in order
+void fillDayMap (DayMap * map, Employee * emp){
+	time_t dayStart = localDay(map->day)->midnight, dayEnd = localDay(map->day + 1)->midnight;
+	Appointment * app = findOverlap(emp->appRoot, dayStart, dayEnd, NULL);
+	memset(map->busy, 0, sizeof(map->busy));
+	while (app!=NULL && app->start < dayEnd){
+		STAT_ADD(STAT_NODES, 1);
+		markDayMap(map, app);
+		app = app->next;
+	}
+}
+
+//sets the slots of the map's day that app covers, by local wall time
+void markDayMap (DayMap * map, Appointment * app){
+	int startDay, startMinutes, endDay, endMinutes;
+	timeToLocal(app->start, &startDay, &startMinutes);
+	timeToLocal(app->start + app->length - 1, &endDay, &endMinutes);
+	long first = (long) (startDay - map->day) * DAY_SLOTS + startMinutes / SLOT_MINUTES;
+	long last = (long) (endDay - map->day) * DAY_SLOTS + endMinutes / SLOT_MINUTES;
+	long s;
+	if (first < 0){
+		first = 0;
+	}
+	if (last >= DAY_SLOTS){
+		last = DAY_SLOTS - 1;
+	}
+	for (s = first; s <= last; s++){
+		map->busy[s / 64] |= (uint64_t) 1 << (s % 64);
+	}
+}
+
+//keeps the maps of the days app covers current after it was added to or taken from emp; a
+//cancelled appointment may share a slot with another, so those days are made again
+void updateDayMaps (Appointment * app, Employee * emp, int added){
+	int startDay, endDay, minutes, day;
+	if (mapIndexCount == 0){
+		return;
+	}
+	timeToLocal(app->start, &startDay, &minutes);
+	timeToLocal(app->start + app->length - 1, &endDay, &minutes);
+	for (day = startDay; day <= endDay; day++){
+		DayMap * map = lookupDayMap(emp->empNum, day);
+		if (map!=NULL){
+			if (added){
+				markDayMap(map, app);
+			} else{
+				fillDayMap(map, emp);
+			}
+		}
+	}
+}
+
+//forgets every map of an employee who is leaving
+void dropDayMaps (int empNum){
+	int i;
+	for (i = 0; i < mapIndexSize && mapIndexCount > 0; i++){
+		DayMap ** link = &mapIndex[i];
+		while (*link!=NULL){
+			DayMap * map = *link;
+			if (map->empNum == empNum){
+				*link = map->hashNext;
+				poolFree(&mapPool, map);
+				mapIndexCount--;
+			} else{
+				link = &map->hashNext;
+			}
+		}
+	}
+}
+
+//index of the lowest set bit of a nonzero word
+int lowestBit (uint64_t word){
+#ifdef __GNUC__
+	return __builtin_ctzll(word);
+#else
+	int bit = 0;
+	while ((word & 1) == 0){
+		word >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+//slots inside window where a run of need free slots starts; runs are found by and-ing the free
+//bits with themselves shifted, doubling the run length covered each time
+void freeStarts (const uint64_t * busy, int need, const uint64_t * window, uint64_t * starts){
+	int covered = 1, w;
+	for (w = 0; w < SLOT_WORDS; w++){
+		starts[w] = ~busy[w];
+	}
+	while (covered < need){
+		int shift = (covered < need - covered) ? covered : need - covered;
+		for (w = 0; w < SLOT_WORDS; w++){
+			uint64_t above = (w + 1 < SLOT_WORDS) ? starts[w + 1] << (64 - shift) : 0;
+			starts[w] &= (starts[w] >> shift) | above;
+		}
+		covered += shift;
+	}
+	for (w = 0; w < SLOT_WORDS; w++){
+		starts[w] &= window[w];
+	}
+}
+
+//the earliest count start times from after on, within the search hours, at which some employee of
+//the position is free for length seconds; each start time is given once, with the first such
+//employee in name order. Looks at every employee of the position, so it needs the same
+//exclusive access as a roster change when several threads share the store.
+int findFreeSlots (int position, time_t after, int length, int count, FreeSlot * slots, int * found){
+	int need = (length + SLOT_MINUTES * 60 - 1) / (SLOT_MINUTES * 60);
+	int firstDay, minutes, day, i, w, s;
+	*found = 0;
+	if (position < 0 || position >= POSITION_COUNT || length <= 0 || length > MAX_APP_MINUTES * 60 || count <= 0){
+		return SPA_INVALID;
+	}
+	
+	//start slots that end by closing time
+	uint64_t hours[SLOT_WORDS], window[SLOT_WORDS];
+	int open = (SEARCH_OPEN + SLOT_MINUTES - 1) / SLOT_MINUTES, close = SEARCH_CLOSE / SLOT_MINUTES - need;
+	memset(hours, 0, sizeof(hours));
+	for (s = open; s <= close; s++){
+		hours[s / 64] |= (uint64_t) 1 << (s % 64);
+	}
+	
+	//the bucket is copied out as far as the search has needed it, with each employee's start slots
+	Employee * next = posHead[position];
+	int members = 0, size = 64;
+	Employee ** staff = (Employee **) malloc(size * sizeof(Employee *));
+	uint64_t * starts = (uint64_t *) malloc(size * SLOT_WORDS * sizeof(uint64_t));
+	
+	timeToLocal(after, &firstDay, &minutes);
+	if (localToTime(firstDay, minutes) < after){
+		minutes++; //part way through a minute
+	}
+	for (day = firstDay; day < firstDay + SEARCH_DAYS && *found < count; day++){
+		uint64_t any[SLOT_WORDS];
+		memcpy(window, hours, sizeof(window));
+		for (s = 0; day == firstDay && s < DAY_SLOTS && s * SLOT_MINUTES < minutes; s++){
+			window[s / 64] &= ~((uint64_t) 1 << (s % 64));
+		}
+		
+		//the first slots still wanted; once someone is free at each of them, later employees can't
+		//do better. Days with a clock change are searched in full in case a candidate fails below.
+		uint64_t first[SLOT_WORDS], rest[SLOT_WORDS];
+		int wanted = 0, searched = 0, complete = EXITED;
+		memset(first, 0, sizeof(first));
+		memcpy(rest, window, sizeof(rest));
+		for (w = 0; w < SLOT_WORDS; w++){
+			while (rest[w] != 0 && wanted < count - *found){
+				first[w] |= rest[w] & -rest[w];
+				rest[w] &= rest[w] - 1;
+				wanted++;
+			}
+		}
+		memset(any, 0, sizeof(any));
+		while ((searched < members || next!=NULL) && !complete){
+			if (searched == members){
+				if (members == size){
+					size *= 2;
+					staff = (Employee **) realloc(staff, size * sizeof(Employee *));
+					starts = (uint64_t *) realloc(starts, size * SLOT_WORDS * sizeof(uint64_t));
+				}
+				staff[members++] = next;
+				next = next->posNext;
+			}
+			freeStarts(findDayMap(staff[searched], day)->busy, need, window, starts + searched * SLOT_WORDS);
+			complete = localDay(day)->regular;
+			for (w = 0; w < SLOT_WORDS; w++){
+				any[w] |= starts[searched * SLOT_WORDS + w];
+				complete = complete && (any[w] & first[w]) == first[w];
+			}
+			searched++;
+		}
+		
+		//in time order; each candidate is checked against the tree, which settles days with a clock change
+		for (w = 0; w < SLOT_WORDS && *found < count; w++){
+			while (any[w] != 0 && *found < count){
+				int bit = lowestBit(any[w]);
+				any[w] &= any[w] - 1;
+				s = w * 64 + bit;
+				time_t start = localToTime(day, s * SLOT_MINUTES);
+				for (i = 0; start >= after && i < searched; i++){
+					if ((starts[i * SLOT_WORDS + w] >> bit & 1) && checkAvailability(staff[i], start, length, NULL) == SPA_OK){
+						slots[*found].emp = staff[i];
+						slots[*found].start = start;
+						(*found)++;
+						break;
+					}
+				}
+			}
+		}
+	}
+	free(staff);
+	free(starts);
+	return SPA_OK;
+}
+
+DayList * findDayList (int day){
+	DayList * list;
+	if (calendarSize == 0){
+		return NULL;
+	}
+	list = calendar[hashId(day, calendarSize)];
+	while (list!=NULL && list->day!=day){
+		STAT_ADD(STAT_NODES, 1);
+		list = list->hashNext;
+	}
+	return list;
+}
+
+void growCalendar (){
+	int newSize = (calendarSize == 0) ? 256 : calendarSize * 2;
+	DayList ** newIndex = (DayList **) calloc (newSize, sizeof(DayList *));
+	int i;
+	for (i = 0; i < calendarSize; i++){
+		DayList * list = calendar[i];
+		while (list!=NULL){
+			DayList * next = list->hashNext;
+			unsigned int slot = hashId(list->day, newSize);
+			list->hashNext = newIndex[slot];
+			newIndex[slot] = list;
+			list = next;
+		}
+	}
+	free (calendar);
+	calendar = newIndex;
+	calendarSize = newSize;
+}
+
+//first position in the day's list not before app
+int dayListPosition (DayList * list, Appointment * app){
+	int lo = 0, hi = list->count;
+	while (lo < hi){
+		int mid = (lo + hi) / 2;
+		STAT_ADD(STAT_NODES, 1);
+		if (compareApps(list->apps[mid], app) < 0){
+			lo = mid + 1;
+		} else{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+//the list of the day app starts on, made if needed, with room for one more
+DayList * dayListFor (Appointment * app){
+	int day, minutes;
+	timeToLocal(app->start, &day, &minutes);
+	DayList * list = findDayList(day);
+	if (list == NULL){
+		if (calendarCount >= calendarSize){
+			growCalendar();
+		}
+		list = (DayList *) calloc(1, sizeof(DayList));
+		list->day = day;
+		unsigned int slot = hashId(day, calendarSize);
+		list->hashNext = calendar[slot];
+		calendar[slot] = list;
+		calendarCount++;
+	}
+	if (list->count == list->size){
+		list->size = (list->size == 0) ? 8 : list->size * 2;
+		list->apps = (Appointment **) realloc(list->apps, list->size * sizeof(Appointment *));
+	}
+	return list;
+}
+
+//files app under the day it starts on; a no-op until the calendar has been asked for
+void calendarAdd (Appointment * app){
+	if (!calendarBuilt){
+		return;
+	}
+	lockShared();
+	DayList * list = dayListFor(app);
+	int pos = dayListPosition(list, app);
+	memmove(list->apps + pos + 1, list->apps + pos, (list->count - pos) * sizeof(Appointment *));
+	list->apps[pos] = app;
+	list->count++;
+	unlockShared();
+}
+
+void calendarRemove (Appointment * app){
+	int day, minutes;
+	if (!calendarBuilt){
+		return;
+	}
+	timeToLocal(app->start, &day, &minutes);
+	lockShared();
+	DayList * list = findDayList(day);
+	if (list!=NULL){
+		int pos = dayListPosition(list, app);
+		if (pos < list->count && list->apps[pos] == app){
+			list->count--;
+			memmove(list->apps + pos, list->apps + pos + 1, (list->count - pos) * sizeof(Appointment *));
+		}
+	}
+	unlockShared();
+}
+
+int compareAppPtrs (const void * a, const void * b){
+	return compareApps(*(Appointment * const *) a, *(Appointment * const *) b);
+}
+
+//files every appointment in one pass over the roster, then sorts each day once
+void buildCalendar (){
+	Employee * emp;
+	int i;
+	for (emp = empRoot; emp!=NULL && emp->left!=NULL; emp = emp->left);
+	for (; emp!=NULL; emp = emp->next){
+		Appointment * app;
+		for (app = emp->app; app!=NULL; app = app->next){
+			DayList * list = dayListFor(app);
+			list->apps[list->count++] = app;
+		}
+	}
+	for (i = 0; i < calendarSize; i++){
+		DayList * list;
+		for (list = calendar[i]; list!=NULL; list = list->hashNext){
+			qsort(list->apps, list->count, sizeof(Appointment *), compareAppPtrs);
+		}
+	}
+	calendarBuilt = ACTIVE;
+}
+
+void clearCalendar (){
+	int i;
+	for (i = 0; i < calendarSize; i++){
+		while (calendar[i]!=NULL){
+			DayList * next = calendar[i]->hashNext;
+			free(calendar[i]->apps);
+			free(calendar[i]);
+			calendar[i] = next;
+		}
+	}
+	calendarCount = 0;
+	calendarBuilt = EXITED;
+}
+
+//the appointments starting on a day, all employees together, in time order; returns how many and
+//points *apps at the calendar's own list, good until the next change. The first call files
+//every appointment, so like a roster change it needs the store to itself while threads share it.
+int findDayApps (int day, Appointment *** apps){
+	if (!calendarBuilt){
+		buildCalendar();
+	}
+	DayList * list = findDayList(day);
+	if (list == NULL){
+		*apps = NULL;
+		return 0;
+	}
+	*apps = list->apps;
+	return list->count;
+}
+
+//restores the heap order below position i
+void siftRange (RangeIter * it, int i){
+	Appointment * app = it->heap[i];
+	while (2 * i + 1 < it->count){
+		int child = 2 * i + 1;
+		if (child + 1 < it->count && compareApps(it->heap[child + 1], it->heap[child]) < 0){
+			child++;
+		}
+		if (compareApps(it->heap[child], app) >= 0){
+			break;
+		}
+		STAT_ADD(STAT_NODES, 1);
+		it->heap[i] = it->heap[child];
+		i = child;
+	}
+	it->heap[i] = app;
+}
+
+//starts a walk over the appointments overlapping [from, to), all employees together, in (start, id)
+//order. Each employee's schedule is entered with one tree search and then followed along its thread,
+//so the walk holds one appointment per employee however long the history is. The store must not
+//change until closeRange(); while threads share it, that means holding it as for a roster change.
+void openRange (RangeIter * it, time_t from, time_t to){
+	Employee * emp;
+	int i;
+	it->to = to;
+	it->count = 0;
+	it->heap = (Appointment **) malloc((empIndexCount > 0 ? empIndexCount : 1) * sizeof(Appointment *));
+	for (emp = empRoot; emp!=NULL && emp->left!=NULL; emp = emp->left);
+	for (; emp!=NULL && from < to; emp = emp->next){
+		//appointments of one employee never overlap, so the ones after the first overlapping one
+		//in the range all overlap it too
+		Appointment * app = findOverlap(emp->appRoot, from, to, NULL);
+		if (app!=NULL){
+			it->heap[it->count++] = app;
+		}
+	}
+	for (i = it->count / 2 - 1; i >= 0; i--){
+		siftRange(it, i);
+	}
+}
+
+//the next appointment of the walk, or NULL at the end
+Appointment * nextInRange (RangeIter * it){
+	if (it->count == 0){
+		return NULL;
+	}
+	Appointment * app = it->heap[0];
+	if (app->next!=NULL && app->next->start < it->to){
+		it->heap[0] = app->next;
+	} else{
+		it->heap[0] = it->heap[--it->count];
+	}
+	if (it->count > 0){
+		siftRange(it, 0);
+	}
+	return app;
+}
+
+void closeRange (RangeIter * it){
+	free(it->heap);
+	it->heap = NULL;
+	it->count = 0;
+}
+
+//moves app to a new start and/or employee in one step: the new slot is checked first, with app
+//itself ignored, and only then is the node relinked, so nothing is freed or allocated and a
+//rejected move leaves the booking exactly as it was, with *conflictId (if given) naming the one in
+//the way. Pass app->id as id to keep the ID; journals from older versions may give a new one.
+int rescheduleAppointment(Appointment * app, Employee * emp, time_t start, int id, int * conflictId){
+	int oldId = app->id;
+	Appointment * conflict = findOverlap(emp->appRoot, start, start + app->length, app);
+	if (conflict!=NULL){
+		if (conflictId!=NULL){
+			*conflictId = conflict->id;
+		}
+		return SPA_CONFLICT;
+	}
+	
+	detachAppointment(app);
+	app->start = start;
+	if (id != oldId){
+		unindexAppointment(app);
+		app->id = id;
+		indexAppointment(app);
+	}
+	attachAppointment(emp, app);
+	journalAppointment(J_MOVE, oldId, app);
+	return SPA_OK;
+}
+
+//books emp from start for length seconds; *id is the new appointment's ID, or on
+//SPA_CONFLICT the ID of the appointment in the way
+int bookAppointment (Employee * emp, time_t start, int length, int * id){
+	if (emp == NULL){
+		return SPA_NOT_FOUND;
+	}
+	if (length <= 0 || length > MAX_APP_MINUTES * 60){
+		return SPA_INVALID;
+	}
+	Appointment * newApp = allocAppointment();
+	newApp->id = generateAppId();
+	newApp->start = start;
+	newApp->length = length;
+	newApp->hashNext = NULL;
+	int conflictId = insertAppointment(emp, newApp);
+	if (conflictId != 0){
+		freeAppointment(newApp);
+		*id = conflictId;
+		return SPA_CONFLICT;
+	}
+	journalAppointment(J_BOOK, newApp->id, newApp);
+	*id = newApp->id;
+	return SPA_OK;
+}
+
+//books many appointments at once, with the same outcome, IDs and journal records as calling
+//bookAppointment() for each in turn; returns how many were booked. The requests are grouped by
+//employee; each is checked against the schedule and against the batch's earlier bookings for the
+//same employee, which are kept in a tree of their own, and then all are linked in with one merge.
+//Changes several employees at once, so it needs the store to itself while threads share it.
+int bookAppointments (Employee * head, Booking * bookings, int count){
+	int size = 16, groupCount = 0, booked = 0, i, g;
+	while (size < 2 * count){
+		size *= 2;
+	}
+	int * slots = (int *) malloc(size * sizeof(int));
+	BookingGroup * groups = (BookingGroup *) malloc((count > 0 ? count : 1) * sizeof(BookingGroup));
+	int * next = (int *) malloc((count > 0 ? count : 1) * sizeof(int)); //next request in the group
+	Appointment ** made = (Appointment **) calloc((count > 0 ? count : 1), sizeof(Appointment *));
+	for (i = 0; i < size; i++){
+		slots[i] = -1;
+	}
+	
+	//IDs are handed out in request order, rejected requests included, as bookAppointment() does;
+	//nodes are only made for the requests that are booked
+	for (i = 0; i < count; i++){
+		Booking * booking = &bookings[i];
+		Employee * emp = findEmp(head, booking->empNum);
+		booking->id = 0;
+		if (emp == NULL){
+			booking->status = SPA_NOT_FOUND;
+			continue;
+		}
+		if (booking->length <= 0 || booking->length > MAX_APP_MINUTES * 60){
+			booking->status = SPA_INVALID;
+			continue;
+		}
+		booking->id = generateAppId();
+		unsigned int slot = hashId(emp->empNum, size);
+		for (g = slots[slot]; g != -1 && groups[g].emp != emp; g = groups[g].hashNext);
+		if (g == -1){
+			g = groupCount++;
+			groups[g].emp = emp;
+			groups[g].first = i;
+			groups[g].hashNext = slots[slot];
+			slots[slot] = g;
+		} else{
+			next[groups[g].last] = i;
+		}
+		groups[g].last = i;
+		next[i] = -1;
+	}
+	
+	for (g = 0; g < groupCount; g++){
+		Employee * emp = groups[g].emp;
+		Appointment * added = NULL;
+		int addedCount = 0;
+		for (i = groups[g].first; i != -1; i = next[i]){
+			Booking * booking = &bookings[i];
+			time_t end = booking->start + booking->length;
+			Appointment * conflict = findOverlap(emp->appRoot, booking->start, end, NULL);
+			Appointment * inBatch = findOverlap(added, booking->start, end, NULL);
+			if (inBatch!=NULL && (conflict == NULL || compareApps(inBatch, conflict) < 0)){
+				conflict = inBatch; //the earliest in the way, as one combined schedule would give it
+			}
+			if (conflict!=NULL){
+				booking->status = SPA_CONFLICT;
+				booking->id = conflict->id;
+			} else{
+				Appointment * app = allocAppointment(), * prev = NULL, * after = NULL;
+				app->id = booking->id;
+				app->start = booking->start;
+				app->length = booking->length;
+				app->hashNext = NULL;
+				added = treeInsertApp(added, app, &prev, &after);
+				booking->status = SPA_OK;
+				made[i] = app;
+				addedCount++;
+			}
+		}
+		mergeBookings(emp, added, addedCount);
+		booked += addedCount;
+	}
+	for (i = 0; i < count; i++){
+		if (made[i]!=NULL){
+			journalAppointment(J_BOOK, made[i]->id, made[i]);
+		}
+	}
+	free(slots);
+	free(groups);
+	free(next);
+	free(made);
+	return booked;
+}
+
+void flattenApps (Appointment * node, Appointment ** out, int * n){
+	if (node!=NULL){
+		flattenApps(node->left, out, n);
+		out[(*n)++] = node;
+		flattenApps(node->right, out, n);
+	}
+}
+
+//links count new appointments, held in a tree of their own and clear of the schedule, into emp's
+//schedule: one by one when they are few next to it, otherwise by merging them into the list and
+//building the tree over the result, which costs one pass over both
+void mergeBookings (Employee * emp, Appointment * added, int count){
+	Appointment ** fresh = (Appointment **) malloc((count > 0 ? count : 1) * sizeof(Appointment *));
+	int n = 0, height = appHeight(emp->appRoot), i;
+	long least = (height > 0) ? 1L << ((height < 40 ? height : 40) - 1) : 0; //nodes in the tree, roughly
+	flattenApps(added, fresh, &n);
+	if ((long) count * (height + 1) < least + count){
+		for (i = 0; i < count; i++){
+			attachAppointment(emp, fresh[i]);
+			indexAppointment(fresh[i]);
+		}
+		free(fresh);
+		return;
+	}
+	
+	Appointment * app;
+	int existing = 0, total, b = 0;
+	for (app = emp->app; app!=NULL; app = app->next){
+		existing++;
+	}
+	total = existing + count;
+	Appointment ** nodes = (Appointment **) malloc((total > 0 ? total : 1) * sizeof(Appointment *));
+	app = emp->app;
+	for (i = 0; i < total; i++){
+		STAT_ADD(STAT_NODES, 1);
+		if (b == count || (app!=NULL && compareApps(app, fresh[b]) < 0)){
+			nodes[i] = app;
+			app = app->next;
+		} else{
+			nodes[i] = fresh[b++];
+		}
+	}
+	for (i = 0; i < total; i++){
+		nodes[i]->prev = (i > 0) ? nodes[i - 1] : NULL;
+		nodes[i]->next = (i + 1 < total) ? nodes[i + 1] : NULL;
+	}
+	emp->app = (total > 0) ? nodes[0] : NULL;
+	emp->appRoot = buildAppTree(nodes, 0, total - 1);
+	for (i = 0; i < count; i++){
+		lockShared();
+		fresh[i]->owner = emp;
+		unlockShared();
+		indexAppointment(fresh[i]);
+		calendarAdd(fresh[i]);
+		updateDayMaps(fresh[i], emp, ACTIVE);
+	}
+	free(nodes);
+	free(fresh);
+}
+
+int cancelAppointment (int id){
+	Appointment * app = findAppointment(id);
+	if (app == NULL){
+		return SPA_NOT_FOUND;
+	}
+	journalAppointment(J_CANCEL, app->id, NULL);
+	unlinkAppointment(app);
+	freeAppointment(app);
+	return SPA_OK;
+}
+
+#ifdef SPA_STATS
+//log2 latency histogram: bucket b holds calls that took under 2^b nanoseconds
+typedef struct stat_hist{
+	uint64_t count;
+	uint64_t totalNs;
+	uint64_t maxNs;
+	uint64_t buckets[64];
+} StatHist;
+
+THREAD_LOCAL uint64_t statCounters[STAT_COUNTERS];
+StatHist statHist[STAT_OPS];
+
+const char * const statCounterNames[STAT_COUNTERS] = {"nodes_visited", "mktime_calls", "localtime_calls", "allocations", "bytes_written"};
+const char * const statOpNames[STAT_OPS] = {"load", "hire", "edit_employee", "fire", "view", "book", "edit_appointment", "cancel", "save"};
+
+uint64_t statClock (){
+	struct timespec ts;
+#ifdef _WIN32
+	timespec_get(&ts, TIME_UTC);
+#else
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void statRecord (int op, uint64_t start){
+	uint64_t ns = statClock() - start;
+	StatHist * hist = &statHist[op];
+	int bucket = 0;
+	while (bucket < 63 && (ns >> bucket) != 0){
+		bucket++;
+	}
+	hist->buckets[bucket]++;
+	hist->count++;
+	hist->totalNs += ns;
+	if (ns > hist->maxNs){
+		hist->maxNs = ns;
+	}
+}
+
+//upper bound of the bucket holding the given fraction of the calls
+uint64_t statPercentile (StatHist * hist, double fraction){
+	uint64_t target = (uint64_t) (hist->count * fraction), seen = 0;
+	int bucket;
+	for (bucket = 0; bucket < 64; bucket++){
+		seen += hist->buckets[bucket];
+		if (seen > target){
+			break;
+		}
+	}
+	if (bucket >= 63 || ((uint64_t) 1 << bucket) > hist->maxNs){
+		return hist->maxNs;
+	}
+	return (uint64_t) 1 << bucket;
+}
+
+//counters, then one line per operation and one per non-empty bucket, as space-separated fields
+int writeStats (const char * name){
+	FILE * fp = fopen(name, "w");
+	int i, b;
+	if (fp == NULL){
+		return SPA_IO_ERROR;
+	}
+	for (i = 0; i < STAT_COUNTERS; i++){
+		fprintf(fp, "counter %s %llu\n", statCounterNames[i], (unsigned long long) statCounters[i]);
+	}
+	for (i = 0; i < STAT_OPS; i++){
+		StatHist * hist = &statHist[i];
+		if (hist->count == 0){
+			continue;
+		}
+		fprintf(fp, "op %s count %llu mean_ns %llu p50_ns %llu p90_ns %llu p99_ns %llu max_ns %llu\n", statOpNames[i],
+			(unsigned long long) hist->count, (unsigned long long) (hist->totalNs / hist->count),
+			(unsigned long long) statPercentile(hist, 0.5), (unsigned long long) statPercentile(hist, 0.9),
+			(unsigned long long) statPercentile(hist, 0.99), (unsigned long long) hist->maxNs);
+		for (b = 0; b < 64; b++){
+			if (hist->buckets[b] != 0){
+				fprintf(fp, "bucket %s %llu %llu\n", statOpNames[i], (unsigned long long) 1 << b, (unsigned long long) hist->buckets[b]);
+			}
+		}
+	}
+	return (fclose(fp) == 0) ? SPA_OK : SPA_IO_ERROR;
+}
+#endif
@@ -0,0 +1,236 @@
+/*
+
+Spa Employee System - core
+
+The roster, the appointment books and their files, without any terminal I/O. Every
+function here runs to completion without prompting or printing, so the engine can be
+driven by the menu program in spa.c, a batch file or a benchmark alike. Operations that
+can fail return one of the SPA_ status codes below.
+
+*/
+
+#ifndef SPA_CORE_H
+#define SPA_CORE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#define ACTIVE 1
+#define EXITED 0
+#define APP_LENGTH 1800 //default length in seconds
+#define MAX_APP_MINUTES 720
+#define POSITION_COUNT 8
+#define POS_NONE POSITION_COUNT //unrecognised position text in a loaded file
+#define NAME_SIZE 20 //longest name accepted plus its terminator, as stored in snapshot records
+#define JOURNAL_COMPACT 500 //journal records between compactions into the snapshot files
+#define SLOT_MINUTES 15 //granularity of the free-slot search
+#define SEARCH_OPEN (8 * 60) //hours searched for free slots, in minutes after midnight; bookings
+#define SEARCH_CLOSE (20 * 60) //outside them are still allowed
+#define SEARCH_DAYS 28 //days looked ahead for free slots
+
+//per-thread storage for the parallel loader, which only runs where threads are available
+#ifdef _WIN32
+#define THREAD_LOCAL
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+//status codes returned by the core operations
+enum spa_status{
+	SPA_OK = 0,
+	SPA_NOT_FOUND, //no employee or appointment with that number
+	SPA_CONFLICT, //the time slot overlaps an existing appointment
+	SPA_INVALID, //a field is out of range
+	SPA_IO_ERROR //a file could not be written
+};
+
+typedef struct app_node{
+	int id;
+	time_t start; //converted from local wall time once, when created or loaded
+	int length; //seconds
+	struct emp_node * owner;
+	struct app_node * next; //in-order thread through the tree
+	struct app_node * prev;
+	struct app_node * hashNext;
+	struct app_node * left; //AVL tree keyed by (start, id)
+	struct app_node * right;
+	int height;
+	time_t maxEnd; //latest end time in this subtree
+} Appointment;
+
+enum position{
+	POS_AESTHETICIAN,
+	POS_HAIR_STYLIST,
+	POS_MASSAGE_THERAPIST,
+	POS_NAIL_TECHNICIAN,
+	POS_SALON_SERVICES_ATTENDANT,
+	POS_SPA_ATTENDANT,
+	POS_SPA_MANAGEMENT,
+	POS_SPA_RECEPTIONIST
+};
+
+//names as stored in employees.txt, indexed by enum position
+extern const char * const positionNames[POSITION_COUNT + 1];
+
+//names and the hiring date are packed; read them through empLast(), empFirst() and empHired()
+typedef struct emp_node{
+	int empNum;
+	uint32_t last; //offsets of interned names in nameArena
+	uint32_t first;
+	int32_t hired; //days since 01/01/1970
+	unsigned char age;
+	unsigned char position; //enum position
+	unsigned char height; //in the name tree
+	uint16_t positions; //bit per position held in this subtree of the name tree
+	Appointment * app;
+	Appointment * appRoot;
+	struct emp_node * next;
+	struct emp_node * prev;
+	struct emp_node * hashNext;
+	struct emp_node * posNext; //bucket of employees with the same position, alphabetical
+	struct emp_node * posPrev;
+	struct emp_node * left; //AVL tree keyed by (last, first, empNum); next/prev thread it in order
+	struct emp_node * right;
+} Employee;
+
+//a free slot found by findFreeSlots()
+typedef struct free_slot{
+	Employee * emp;
+	time_t start;
+} FreeSlot;
+
+//a walk in time order over every employee's appointments in a time range; see openRange()
+typedef struct range_iter{
+	time_t to;
+	Appointment ** heap; //min-heap holding each employee's next appointment in the range
+	int count;
+} RangeIter;
+
+//one request of a bookAppointments() batch; status and id are filled in as bookAppointment() would
+typedef struct booking{
+	int empNum;
+	time_t start;
+	int length; //seconds
+	int status; //SPA_ status code
+	int id; //the new appointment, or on SPA_CONFLICT the one in the way, which may be from the batch
+} Booking;
+
+//what loadStore() found, for the caller to report
+typedef struct load_report{
+	int fromSnapshot; //ACTIVE when spa.snap was current and used
+	int snapshotRejected; //spa.snap was damaged or from another version
+	int skipped; //appointments in appointments.txt that could not be loaded
+	int recovered; //journal records replayed on top of the files
+} LoadReport;
+
+//store functions
+int loadStore (Employee ** head, LoadReport * report);
+int saveStore (Employee * head);
+void closeStore ();
+void reportPools (Employee * head, FILE * out);
+Employee * loadEmployees (Employee * head);
+int loadAppointments (Employee * head);
+int saveEmployees (Employee * head);
+int saveAppointments (Employee * head);
+int loadTextFiles (Employee ** head);
+void endThread ();
+
+//employee operations
+int hireEmployee (Employee ** head, Employee * details, Employee ** hired);
+int changeEmployee (Employee ** head, int empNum, Employee * details);
+int fireEmployee (Employee ** head, int empNum);
+int fireAllEmployees (Employee ** head);
+Employee * findEmp (Employee * head, int empNum);
+Employee * findBySurname (const char * prefix);
+
+//appointment operations
+int bookAppointment (Employee * emp, time_t start, int length, int * id);
+int bookAppointments (Employee * head, Booking * bookings, int count);
+int rescheduleAppointment (Appointment * app, Employee * emp, time_t start, int id, int * conflictId);
+int cancelAppointment (int id);
+int generateAppId ();
+Appointment * findAppointment (int id);
+Employee * findBookedEmp (Employee * head, int appId);
+int checkAvailability (Employee * emp, time_t start, int length, int * conflictId);
+int findFreeSlots (int position, time_t after, int length, int count, FreeSlot * slots, int * found);
+int findDayApps (int day, Appointment *** apps);
+void openRange (RangeIter * it, time_t from, time_t to);
+Appointment * nextInRange (RangeIter * it);
+void closeRange (RangeIter * it);
+
+//record accessors
+const char * empLast (Employee * emp);
+const char * empFirst (Employee * emp);
+void setEmpName (Employee * emp, const char * last, const char * first);
+int empHired (Employee * emp);
+void setEmpHired (Employee * emp, int days);
+int findPosition (const char * name);
+
+//civil date functions
+int daysFromCivil (int year, int month, int day);
+void civilFromDays (int days, int * year, int * month, int * day);
+int fullYear (int year);
+int daysInMonth (int year, int month);
+int parseDate (const char * text, int * days);
+int parseClock (const char * text, int * minutes);
+void formatDate (char * out, int days);
+void formatSchedule (char * out, time_t start);
+time_t localToTime (int days, int minutes);
+void timeToLocal (time_t t, int * days, int * minutes);
+
+//optional instrumentation: build with -DSPA_STATS to count the work done in the hot paths and
+//keep a latency histogram per menu operation; without it the STAT_ macros compile to nothing
+#define STATS_FILE "spa.stats"
+
+enum stat_counter{
+	STAT_NODES, //tree, list and hash-chain nodes visited
+	STAT_MKTIME, //mktime calls
+	STAT_LOCALTIME, //localtime calls
+	STAT_ALLOCS, //employee and appointment nodes allocated
+	STAT_BYTES, //bytes written to the data files and the journal
+	STAT_COUNTERS
+};
+
+enum stat_op{
+	OP_LOAD,
+	OP_HIRE,
+	OP_EDIT_EMP,
+	OP_FIRE,
+	OP_VIEW,
+	OP_BOOK,
+	OP_EDIT_APP,
+	OP_CANCEL,
+	OP_SAVE,
+	STAT_OPS
+};
+
+#ifdef SPA_STATS
+extern THREAD_LOCAL uint64_t statCounters[STAT_COUNTERS]; //loader threads add theirs to the main thread's
+#define STAT_ADD(counter, n) (statCounters[counter] += (n))
+#define STAT_BEGIN(start) uint64_t start = statClock()
+#define STAT_END(op, start) statRecord(op, start)
+uint64_t statClock ();
+void statRecord (int op, uint64_t start);
+int writeStats (const char * name);
+#else
+#define STAT_ADD(counter, n) ((void) 0)
+#define STAT_BEGIN(start) ((void) 0)
+#define STAT_END(op, start) ((void) 0)
+#endif
+
+//per-position buckets over the roster, alphabetical within each position
+extern Employee * posHead[POSITION_COUNT + 1];
+
+//journal records written since the last saveStore()
+extern int journalCount;
+
+//threads used by loadTextFiles(); 0 means one per core, for appointment files large enough to split
+extern int loadThreads;
+
+//set before several threads use the store at once. The core then locks what all employees share:
+//the appointment index and pool, the ID counter and the journal. Callers still need to keep
+//roster changes apart from everything else, and operations on one employee apart from each other.
+extern int sharedStore;
+
+#endif
@@ -0,0 +1,253 @@
+/*
+
+Spa Employee System - booking server load test
+
+Connects a growing number of clients to a running spa_server and has each book random
+30-minute slots as fast as the server answers, to show how booking throughput scales with
+the number of clients. The bookings made are cancelled again after each round, untimed, so
+the appointment books end as they started. Build and run with
+	cc -O2 -pthread -o spa_loadtest spa_loadtest.c
+	./spa_loadtest [-s socket] [-c 1,2,4,8] [-n bookings per client] [-d days]
+
+Prints one JSON line per client count.
+
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#define SOCKET_FILE "spa.sock"
+#define MAX_CLIENTS 256
+#define LINE_SIZE 256
+#define FIRST_DAY 20454 //01/01/26
+
+typedef struct client{
+	unsigned int seed;
+	int ok;
+	int conflicts;
+	int failed;
+	int * ids; //appointments booked, cancelled after the round
+	double * latency; //seconds per booking
+} Client;
+
+//client functions
+int connectServer (FILE ** in, FILE ** out);
+int request (FILE * in, FILE * out, const char * line, char * reply);
+void * runClient (void * arg);
+double now ();
+int compareDoubles (const void * a, const void * b);
+unsigned int nextRandom (unsigned int * state);
+
+const char * socketPath = SOCKET_FILE;
+int bookings = 1000, days = 30;
+int * empNums = NULL;
+int empCount = 0;
+pthread_mutex_t gateLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t gateOpen = PTHREAD_COND_INITIALIZER;
+int started = 0; //clients connected and waiting
+int go = 0;
+
+int main (int argc, char ** argv){
+	char counts[LINE_SIZE] = "1,2,4,8";
+	char reply[LINE_SIZE];
+	FILE * in, * out;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "s:c:n:d:")) != -1){
+		switch (opt){
+			case 's': socketPath = optarg; break;
+			case 'c': snprintf(counts, sizeof(counts), "%s", optarg); break;
+			case 'n': bookings = atoi(optarg); break;
+			case 'd': days = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-s socket] [-c 1,2,4,8] [-n bookings per client] [-d days]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (bookings < 1 || days < 1){
+		fprintf(stderr, "NOTE: -n and -d must be positive.\n");
+		return 1;
+	}
+
+	//the employee numbers to book against
+	if (!connectServer(&in, &out) || !request(in, out, "list\n", reply) || strncmp(reply, "OK ", 3) != 0){
+		fprintf(stderr, "NOTE: could not list the employees at %s.\n", socketPath);
+		return 1;
+	}
+	empCount = atoi(reply + 3);
+	empNums = (int *) malloc((empCount > 0 ? empCount : 1) * sizeof(int));
+	for (i = 0; i < empCount && fgets(reply, sizeof(reply), in)!=NULL; i++){
+		empNums[i] = atoi(reply);
+	}
+	fclose(in);
+	fclose(out);
+	if (empCount == 0){
+		fprintf(stderr, "NOTE: the server has no employees to book.\n");
+		return 1;
+	}
+
+	char * next = counts;
+	while (*next != 0){
+		int clients = (int) strtol(next, &next, 10);
+		if (*next == ','){
+			next++;
+		}
+		if (clients < 1 || clients > MAX_CLIENTS){
+			continue;
+		}
+		pthread_t threads[MAX_CLIENTS];
+		Client state[MAX_CLIENTS];
+		started = 0;
+		go = 0;
+		for (i = 0; i < clients; i++){
+			memset(&state[i], 0, sizeof(Client));
+			state[i].seed = 2463534242u + 7919 * i + 104729 * clients;
+			state[i].ids = (int *) malloc(bookings * sizeof(int));
+			state[i].latency = (double *) malloc(bookings * sizeof(double));
+			pthread_create(&threads[i], NULL, runClient, &state[i]);
+		}
+
+		//opens the gate once every client has connected, so none runs alone at the start
+		pthread_mutex_lock(&gateLock);
+		while (started < clients){
+			pthread_cond_wait(&gateOpen, &gateLock);
+		}
+		go = 1;
+		double begin = now();
+		pthread_cond_broadcast(&gateOpen);
+		pthread_mutex_unlock(&gateLock);
+		for (i = 0; i < clients; i++){
+			pthread_join(threads[i], NULL);
+		}
+		double seconds = now() - begin;
+
+		int ok = 0, conflicts = 0, failed = 0, n = 0;
+		double * all = (double *) malloc(clients * bookings * sizeof(double));
+		for (i = 0; i < clients; i++){
+			ok += state[i].ok;
+			conflicts += state[i].conflicts;
+			failed += state[i].failed;
+			memcpy(all + n, state[i].latency, (state[i].ok + state[i].conflicts) * sizeof(double));
+			n += state[i].ok + state[i].conflicts;
+			free(state[i].ids);
+			free(state[i].latency);
+		}
+		qsort(all, n, sizeof(double), compareDoubles);
+		printf("{\"clients\":%d,\"bookings\":%d,\"ok\":%d,\"conflicts\":%d,\"failed\":%d,\"seconds\":%.3f,"
+			"\"bookings_per_sec\":%.0f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f}\n",
+			clients, n, ok, conflicts, failed, seconds, n / seconds,
+			n > 0 ? all[n / 2] * 1e6 : 0.0, n > 0 ? all[(int) (n * 0.99)] * 1e6 : 0.0, n > 0 ? all[n - 1] * 1e6 : 0.0);
+		fflush(stdout);
+		free(all);
+	}
+	free(empNums);
+	return 0;
+}
+
+//one client: waits at the gate, books, then cancels what it booked
+void * runClient (void * arg){
+	Client * client = (Client *) arg;
+	unsigned int seed = client->seed;
+	char line[LINE_SIZE], reply[LINE_SIZE];
+	FILE * in = NULL, * out = NULL;
+	int connected = connectServer(&in, &out);
+	int i, year, booked = 0;
+
+	pthread_mutex_lock(&gateLock);
+	started++;
+	pthread_cond_broadcast(&gateOpen);
+	while (!go){
+		pthread_cond_wait(&gateOpen, &gateLock);
+	}
+	pthread_mutex_unlock(&gateLock);
+	if (!connected){
+		client->failed = bookings;
+		return NULL;
+	}
+
+	for (i = 0; i < bookings; i++){
+		//a 15-minute grid from 08:00 to 19:45
+		int emp = empNums[nextRandom(&seed) % empCount];
+		int day = FIRST_DAY + nextRandom(&seed) % days;
+		int slot = 32 + nextRandom(&seed) % 48;
+		time_t t = (time_t) day * 86400;
+		struct tm date;
+		gmtime_r(&t, &date);
+		year = date.tm_year % 100;
+		snprintf(line, sizeof(line), "book|%d|%02d/%02d/%02d|%02d:%02d|30\n", emp, date.tm_mon + 1, date.tm_mday, year, slot / 4, slot % 4 * 15);
+		double start = now();
+		if (!request(in, out, line, reply)){
+			client->failed += bookings - i;
+			break;
+		}
+		client->latency[client->ok + client->conflicts] = now() - start;
+		if (strncmp(reply, "OK ", 3) == 0){
+			client->ids[booked++] = atoi(reply + 3);
+			client->ok++;
+		} else if (strncmp(reply, "ERR conflict", 12) == 0){
+			client->conflicts++;
+		} else{
+			client->failed++;
+		}
+	}
+	for (i = 0; i < booked; i++){
+		snprintf(line, sizeof(line), "cancel|%d\n", client->ids[i]);
+		if (!request(in, out, line, reply)){
+			break;
+		}
+	}
+	fclose(in);
+	fclose(out);
+	return NULL;
+}
+
+int connectServer (FILE ** in, FILE ** out){
+	struct sockaddr_un addr;
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socketPath);
+	if (fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0){
+		if (fd >= 0){
+			close(fd);
+		}
+		return 0;
+	}
+	*in = fdopen(fd, "r");
+	*out = fdopen(dup(fd), "w");
+	return *in!=NULL && *out!=NULL;
+}
+
+//sends one command line and reads the reply line
+int request (FILE * in, FILE * out, const char * line, char * reply){
+	if (fputs(line, out) == EOF || fflush(out) != 0){
+		return 0;
+	}
+	return fgets(reply, LINE_SIZE, in)!=NULL;
+}
+
+double now (){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int compareDoubles (const void * a, const void * b){
+	double x = *(const double *) a, y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+//xorshift32
+unsigned int nextRandom (unsigned int * state){
+	unsigned int x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
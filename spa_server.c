@@ -0,0 +1,358 @@
+/*
+
+Spa Employee System - booking server
+
+Serves the store to many clients at once over a Unix-domain socket, so several front desks
+can book at the same time. A client sends one command per line: the batch commands of
+spa_batch.h, or one of the reads below. Every command gets a reply line, "OK <id>" or
+"ERR <reason> [<id>]"; list and view follow theirs with <n> lines of data. Build and run in
+the directory holding the data files with
+	cc -O2 -pthread -o spa_server spa_server.c spa_core.c spa_batch.c
+	./spa_server [socket]		(default spa.sock)
+
+	list				OK <n>, then n lines empNum|Last|First|age|POSITION|hired
+	view|empNum			OK <n>, then the employee line and n-1 lines date|HH:MM|id|minutes
+	free|empNum|date|time|minutes	OK 0 when the slot is free, else ERR conflict <id>
+	quit				closes the connection
+
+Roster changes (hire, edit, fire, fireall, save) hold the store lock exclusively. Everything
+else holds it shared, plus the lock of each employee involved: read by view and free, written
+by book, reschedule, reassign and cancel. Bookings for different employees therefore run in
+parallel, and the conflict check and insert for one employee happen as one step. Employee
+locks are striped by employee number. Lines are parsed before any lock is taken, which is
+safe because parsing only fills in the command: the names of a hire or edit go into the
+shared name store when the command runs, under the exclusive lock. SIGINT or SIGTERM saves the files and stops the server.
+
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "spa_core.h"
+#include "spa_batch.h"
+#define SOCKET_FILE "spa.sock"
+#define EMP_LOCKS 1024 //employee lock stripes, a power of two
+#define SERVER_COMPACT 100000 //changes between saves of the data files
+
+//server functions
+void * serveClient (void * arg);
+void serveLine (char * line, FILE * out);
+void serveRead (char ** fields, int count, FILE * out);
+void lockEmps (int empNum, int other, int write);
+void unlockEmps (int empNum, int other);
+Employee * lockBooked (int appId, int other);
+void writeEmployee (Employee * emp, FILE * out);
+void countChange ();
+void stopServer (int sig);
+
+Employee * head = NULL;
+pthread_rwlock_t storeLock = PTHREAD_RWLOCK_INITIALIZER;
+pthread_rwlock_t empLocks[EMP_LOCKS];
+pthread_mutex_t changeLock = PTHREAD_MUTEX_INITIALIZER;
+int changes = 0; //since the files were last saved
+volatile sig_atomic_t stopping = 0;
+
+//reply words for the SPA_ status codes
+const char * const replyNames[] = {"ok", "not_found", "conflict", "invalid", "io_error"};
+
+int main (int argc, char ** argv){
+	const char * path = (argc > 1) ? argv[1] : SOCKET_FILE;
+	struct sockaddr_un addr;
+	LoadReport report;
+	int i;
+
+	if (strlen(path) >= sizeof(addr.sun_path)){
+		fprintf(stderr, "NOTE: socket path %s is too long.\n", path);
+		return 1;
+	}
+	loadStore(&head, &report);
+	if (report.snapshotRejected){
+		printf("NOTE: spa.snap is damaged or from another version; loading the text files instead.\n");
+	}
+	if (report.skipped > 0){
+		printf("NOTE: %d appointments in appointments.txt could not be loaded.\n", report.skipped);
+	}
+	if (report.recovered > 0){
+		printf("NOTE: recovered %d unsaved changes from spa.journal.\n", report.recovered);
+	}
+	for (i = 0; i < EMP_LOCKS; i++){
+		pthread_rwlock_init(&empLocks[i], NULL);
+	}
+	sharedStore = ACTIVE;
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+	if (listener < 0 || bind(listener, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(listener, 128) != 0){
+		fprintf(stderr, "NOTE: could not listen on %s.\n", path);
+		closeStore();
+		return 1;
+	}
+
+	//no SA_RESTART, so a signal ends the accept() below
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stopServer;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+	printf("Serving %s\n", path);
+	fflush(stdout);
+
+	while (!stopping){
+		int fd = accept(listener, NULL, NULL);
+		if (fd < 0){
+			if (errno != EINTR){
+				perror("accept");
+			}
+			continue;
+		}
+		pthread_t thread;
+		int * arg = (int *) malloc(sizeof(int));
+		*arg = fd;
+		if (pthread_create(&thread, NULL, serveClient, arg) != 0){
+			close(fd);
+			free(arg);
+			continue;
+		}
+		pthread_detach(thread);
+	}
+
+	//waits for the commands in progress; clients still connected are cut off at exit
+	close(listener);
+	unlink(path);
+	pthread_rwlock_wrlock(&storeLock);
+	if (saveStore(head) != SPA_OK){
+		printf("NOTE: could not write the data files; changes are kept in spa.journal.\n");
+	}
+	closeStore();
+	printf("Saved and stopped.\n");
+	return 0;
+}
+
+void stopServer (int sig){
+	(void) sig;
+	stopping = 1;
+}
+
+void * serveClient (void * arg){
+	int fd = *(int *) arg;
+	free(arg);
+	FILE * in = fdopen(fd, "r");
+	FILE * out = fdopen(dup(fd), "w");
+	char line[COMMAND_SIZE];
+
+	while (in!=NULL && out!=NULL && fgets(line, sizeof(line), in)!=NULL){
+		if (strchr(line, '\n') == NULL && !feof(in)){
+			int c;
+			while ((c = fgetc(in)) != EOF && c != '\n');
+			fprintf(out, "ERR invalid\n");
+		} else if (strncmp(line, "quit", 4) == 0 && strchr("\r\n", line[4])){
+			break;
+		} else{
+			serveLine(line, out);
+		}
+		if (fflush(out) != 0){
+			break;
+		}
+	}
+	if (in!=NULL){
+		fclose(in);
+	}
+	if (out!=NULL){
+		fclose(out);
+	}
+	endThread();
+	return NULL;
+}
+
+void serveLine (char * line, FILE * out){
+	Command cmd;
+	CommandResult result;
+	char * fields[6];
+	size_t word = strcspn(line, "|\r\n");
+
+	if ((word == 4 && (strncmp(line, "list", 4) == 0 || strncmp(line, "view", 4) == 0 || strncmp(line, "free", 4) == 0))){
+		int count = splitFields(line, fields, 5);
+		pthread_rwlock_rdlock(&storeLock);
+		serveRead(fields, count, out);
+		pthread_rwlock_unlock(&storeLock);
+		return;
+	}
+	if (parseCommand(line, &cmd) != SPA_OK){
+		fprintf(out, "ERR invalid\n");
+		return;
+	}
+
+	switch (cmd.type){
+		case CMD_BOOK:
+			pthread_rwlock_rdlock(&storeLock);
+			lockEmps(cmd.empNum, -1, ACTIVE);
+			runCommand(&head, &cmd, &result);
+			unlockEmps(cmd.empNum, -1);
+			pthread_rwlock_unlock(&storeLock);
+			break;
+		case CMD_RESCHEDULE:
+		case CMD_REASSIGN:
+		case CMD_CANCEL:{
+			int other = (cmd.type == CMD_REASSIGN) ? cmd.empNum : -1;
+			pthread_rwlock_rdlock(&storeLock);
+			Employee * owner = lockBooked(cmd.appId, other);
+			if (owner == NULL){
+				result.status = SPA_NOT_FOUND;
+				result.id = 0;
+			} else{
+				runCommand(&head, &cmd, &result);
+				unlockEmps(owner->empNum, other);
+			}
+			pthread_rwlock_unlock(&storeLock);
+			break;
+		}
+		default: //hire, edit, fire, fireall and save change the roster itself
+			pthread_rwlock_wrlock(&storeLock);
+			runCommand(&head, &cmd, &result);
+			if (cmd.type == CMD_SAVE && result.status == SPA_OK){
+				pthread_mutex_lock(&changeLock);
+				changes = 0;
+				pthread_mutex_unlock(&changeLock);
+			}
+			pthread_rwlock_unlock(&storeLock);
+	}
+
+	if (result.status == SPA_OK){
+		fprintf(out, "OK %d\n", result.id);
+		if (cmd.type != CMD_SAVE){
+			countChange();
+		}
+	} else if (result.status == SPA_CONFLICT){
+		fprintf(out, "ERR conflict %d\n", result.id);
+	} else{
+		fprintf(out, "ERR %s\n", replyNames[result.status]);
+	}
+}
+
+//list, view and free, under the shared store lock
+void serveRead (char ** fields, int count, FILE * out){
+	int empNum, days, minutes, length, conflictId = 0;
+	Employee * emp;
+	if (strcmp(fields[0], "list") == 0 && count == 1){
+		int n = 0;
+		for (emp = head; emp!=NULL; emp = emp->next){
+			n++;
+		}
+		fprintf(out, "OK %d\n", n);
+		for (emp = head; emp!=NULL; emp = emp->next){
+			writeEmployee(emp, out);
+		}
+	} else if (strcmp(fields[0], "view") == 0 && count == 2 && parseNumber(fields[1], &empNum)){
+		lockEmps(empNum, -1, EXITED);
+		emp = findEmp(head, empNum);
+		if (emp == NULL){
+			fprintf(out, "ERR not_found\n");
+		} else{
+			Appointment * app;
+			int n = 1;
+			for (app = emp->app; app!=NULL; app = app->next){
+				n++;
+			}
+			fprintf(out, "OK %d\n", n);
+			writeEmployee(emp, out);
+			for (app = emp->app; app!=NULL; app = app->next){
+				char date[9];
+				timeToLocal(app->start, &days, &minutes);
+				formatDate(date, days);
+				fprintf(out, "%s|%02d:%02d|%d|%d\n", date, minutes / 60, minutes % 60, app->id, app->length / 60);
+			}
+		}
+		unlockEmps(empNum, -1);
+	} else if (strcmp(fields[0], "free") == 0 && count == 5 && parseNumber(fields[1], &empNum) && parseDate(fields[2], &days)
+		&& parseClock(fields[3], &minutes) && parseNumber(fields[4], &length)){
+		lockEmps(empNum, -1, EXITED);
+		int status = checkAvailability(findEmp(head, empNum), localToTime(days, minutes), length * 60, &conflictId);
+		unlockEmps(empNum, -1);
+		if (status == SPA_OK){
+			fprintf(out, "OK 0\n");
+		} else if (status == SPA_CONFLICT){
+			fprintf(out, "ERR conflict %d\n", conflictId);
+		} else{
+			fprintf(out, "ERR %s\n", replyNames[status]);
+		}
+	} else{
+		fprintf(out, "ERR invalid\n");
+	}
+}
+
+void writeEmployee (Employee * emp, FILE * out){
+	char date[9];
+	formatDate(date, empHired(emp));
+	fprintf(out, "%d|%s|%s|%d|%s|%s\n", emp->empNum, empLast(emp), empFirst(emp), emp->age, positionNames[emp->position], date);
+}
+
+//locks the stripes of one or two employees (other < 0 for none), lower stripe first
+void lockEmps (int empNum, int other, int write){
+	unsigned int a = (unsigned int) empNum & (EMP_LOCKS - 1), b = (unsigned int) other & (EMP_LOCKS - 1);
+	if (other < 0 || a == b){
+		b = a;
+	} else if (b < a){
+		unsigned int swap = a;
+		a = b;
+		b = swap;
+	}
+	if (write){
+		pthread_rwlock_wrlock(&empLocks[a]);
+		if (b != a){
+			pthread_rwlock_wrlock(&empLocks[b]);
+		}
+	} else{
+		pthread_rwlock_rdlock(&empLocks[a]);
+	}
+}
+
+void unlockEmps (int empNum, int other){
+	unsigned int a = (unsigned int) empNum & (EMP_LOCKS - 1), b = (unsigned int) other & (EMP_LOCKS - 1);
+	pthread_rwlock_unlock(&empLocks[a]);
+	if (other >= 0 && b != a){
+		pthread_rwlock_unlock(&empLocks[b]);
+	}
+}
+
+//write-locks the employee holding appointment appId, and other as well; the holder is checked
+//again once locked, since it can change while waiting. NULL when there is no such appointment.
+Employee * lockBooked (int appId, int other){
+	while (1){
+		Employee * owner = findBookedEmp(head, appId);
+		if (owner == NULL){
+			return NULL;
+		}
+		lockEmps(owner->empNum, other, ACTIVE);
+		if (findBookedEmp(head, appId) == owner){
+			return owner;
+		}
+		unlockEmps(owner->empNum, other);
+	}
+}
+
+//saves the files once enough changes have piled up in the journal
+void countChange (){
+	pthread_mutex_lock(&changeLock);
+	int due = (++changes >= SERVER_COMPACT);
+	pthread_mutex_unlock(&changeLock);
+	if (due){
+		pthread_rwlock_wrlock(&storeLock);
+		pthread_mutex_lock(&changeLock);
+		if (changes >= SERVER_COMPACT && saveStore(head) == SPA_OK){
+			changes = 0;
+		}
+		pthread_mutex_unlock(&changeLock);
+		pthread_rwlock_unlock(&storeLock);
+	}
+}